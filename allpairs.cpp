@@ -0,0 +1,191 @@
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Scores every pair of known hashes at once for the modes which compare
+// the knowns against each other. Since fuzzy_compare() is symmetric,
+// each unordered pair is scored once, from its lower index, and the
+// result is recorded for both files. The rows of the triangle are handed
+// out to worker threads a tile at a time. Each worker keeps what it finds
+// to itself, and the results are sorted into rows afterwards so the
+// output doesn't depend on how the work was scheduled.
+
+#include "match.h"
+
+#include <algorithm>
+
+#ifdef HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
+// Rows handed to a worker at a time. Earlier rows have more pairs to
+// score than later ones, so the tiles are kept small enough to even
+// out the load.
+#define ROWS_PER_TILE  32
+
+
+typedef struct
+{
+  uint32_t row;
+  uint32_t col;
+  int      score;
+} pair_score;
+
+
+typedef struct
+{
+  const state * s;
+  int           min_score;
+  uint32_t      next_row;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t lock;
+#endif
+} pair_job;
+
+
+typedef struct
+{
+  pair_job * job;
+  std::vector<pair_score> found;
+} pair_worker;
+
+
+// Claim the next tile of rows. Returns false when there are none left.
+static bool next_tile(pair_job *job, uint32_t *start, uint32_t *stop)
+{
+  uint32_t total = job->s->all_files.size();
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&job->lock);
+#endif
+  *start = job->next_row;
+  *stop  = std::min(total, *start + ROWS_PER_TILE);
+  job->next_row = *stop;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&job->lock);
+#endif
+
+  return (*start < *stop);
+}
+
+
+static void * score_tiles(void *arg)
+{
+  pair_worker * w = (pair_worker *)arg;
+  const state * s = w->job->s;
+  std::vector<uint32_t> ids;
+  std::vector<uint32_t>::const_iterator it;
+  uint32_t start, stop;
+  struct fuzzy_parsed_digest d, known;
+
+  while (next_tile(w->job, &start, &stop))
+  {
+    for (uint32_t row = start ; row < stop ; ++row)
+    {
+      s->all_files.get_digest(row, d);
+
+      // Only knowns which share a 7-gram with this one can score
+      // above zero, and those below it were scored from their own row.
+      s->known_index.candidates(d, ids);
+      for (it = std::upper_bound(ids.begin(), ids.end(), row) ;
+	   it != ids.end() ;
+	   ++it)
+      {
+	s->all_files.get_digest(*it, known);
+	int score = fuzzy_compare_digest_threshold(&d, &known,
+						   w->job->min_score);
+	if (score > 0)
+	{
+	  pair_score p;
+	  p.row   = row;
+	  p.col   = *it;
+	  p.score = score;
+	  w->found.push_back(p);
+	}
+      }
+    }
+  }
+
+  return NULL;
+}
+
+
+static bool col_less(const std::pair<uint32_t,int>& a,
+		     const std::pair<uint32_t,int>& b)
+{
+  return a.first < b.first;
+}
+
+
+bool match_all_pairs(const state *s, int min_score, pair_table& t)
+{
+  if (NULL == s)
+    return true;
+
+  uint32_t total = s->all_files.size();
+  unsigned int count = std::max(1u, s->threads);
+  std::vector<pair_worker> workers(count);
+
+  pair_job job;
+  job.s         = s;
+  job.min_score = min_score;
+  job.next_row  = 0;
+  for (unsigned int i = 0 ; i < count ; ++i)
+    workers[i].job = &job;
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_init(&job.lock, NULL);
+
+  // The calling thread does its share of the work too
+  std::vector<pthread_t> threads(count);
+  unsigned int started = 1;
+  for ( ; started < count ; ++started)
+    if (pthread_create(&threads[started], NULL, score_tiles, &workers[started]))
+      break;
+  score_tiles(&workers[0]);
+  for (unsigned int i = 1 ; i < started ; ++i)
+    pthread_join(threads[i], NULL);
+
+  pthread_mutex_destroy(&job.lock);
+#else
+  score_tiles(&workers[0]);
+#endif
+
+  // Every pair found goes in the rows of both of its files
+  t.start.assign(total + 1, 0);
+  std::vector<pair_worker>::const_iterator w;
+  std::vector<pair_score>::const_iterator p;
+  for (w = workers.begin() ; w != workers.end() ; ++w)
+    for (p = w->found.begin() ; p != w->found.end() ; ++p)
+    {
+      t.start[p->row + 1]++;
+      t.start[p->col + 1]++;
+    }
+  for (uint32_t i = 0 ; i < total ; ++i)
+    t.start[i + 1] += t.start[i];
+
+  std::vector<uint32_t> fill(t.start.begin(), t.start.end() - 1);
+  t.matches.resize(t.start[total]);
+  for (w = workers.begin() ; w != workers.end() ; ++w)
+    for (p = w->found.begin() ; p != w->found.end() ; ++p)
+    {
+      t.matches[fill[p->row]++] = std::make_pair(p->col, p->score);
+      t.matches[fill[p->col]++] = std::make_pair(p->row, p->score);
+    }
+
+  for (uint32_t i = 0 ; i < total ; ++i)
+    std::sort(t.matches.begin() + t.start[i],
+	      t.matches.begin() + t.start[i + 1],
+	      col_less);
+
+  return false;
+}
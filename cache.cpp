@@ -0,0 +1,236 @@
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// The cache file is text. The first line is CACHE_HEADER, and each line
+// after it is one entry:
+//
+//   device,inode,size,mtime,ctime,day last used,signature
+//
+// A file with any other header is treated as an empty cache and is
+// replaced when the cache is saved. Lines which can't be read are
+// skipped, since the worst a lost entry can do is make us hash the
+// file again.
+
+#include "cache.h"
+#include "fuzzy.h"
+
+#include <time.h>
+#include <vector>
+
+// Inode numbers don't identify files on Windows
+#ifndef _WIN32
+
+#define CACHE_HEADER  "ssdeep-cache,1"
+
+// Entries not used for this many days are dropped
+#define SSDEEP_CACHE_DAYS  30
+
+// A file changed again within a second of being hashed could keep the
+// same times, so files changed this recently aren't cached yet.
+#define CACHE_SETTLE_SECONDS  2
+
+#define CACHE_LINE_MAX  (6 * 21 + FUZZY_MAX_RESULT + 2)
+
+
+static uint32_t today(void)
+{
+  return (uint32_t)(time(NULL) / 86400);
+}
+
+
+HashCache::HashCache() : m_today(today()), m_changed(false)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_init(&m_lock, NULL);
+#endif
+}
+
+
+HashCache::~HashCache()
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_destroy(&m_lock);
+#endif
+}
+
+
+bool HashCache::load(const char *fn)
+{
+  char line[CACHE_LINE_MAX];
+
+  m_filename = fn;
+  FILE * handle = fopen(fn, "rb");
+  if (NULL == handle)
+    return (errno != ENOENT);
+
+  if (NULL == fgets(line, sizeof(line), handle) or
+      strncmp(line, CACHE_HEADER "\n", sizeof(CACHE_HEADER)) != 0)
+  {
+    // Not a cache we can read. It is rewritten on save.
+    m_changed = true;
+    fclose(handle);
+    return false;
+  }
+
+  while (NULL != fgets(line, sizeof(line), handle))
+  {
+    unsigned long long dev, ino, size, used;
+    long long mtime, ctime;
+    int pos = 0;
+    if (sscanf(line, "%llu,%llu,%llu,%lld,%lld,%llu,%n",
+	       &dev, &ino, &size, &mtime, &ctime, &used, &pos) != 6 or
+	0 == pos)
+      continue;
+
+    char * sum = line + pos;
+    sum[strcspn(sum, "\r\n")] = 0;
+    struct fuzzy_parsed_digest d;
+    if (fuzzy_parse_digest(&d, sum))
+      continue;
+
+    entry& e = m_entries[key(dev, ino)];
+    e.size  = size;
+    e.mtime = mtime;
+    e.ctime = ctime;
+    e.used  = (uint32_t)used;
+    e.sum   = sum;
+  }
+
+  bool error = (ferror(handle) != 0);
+  fclose(handle);
+  return error;
+}
+
+
+bool HashCache::save(void)
+{
+  if (m_filename.empty())
+    return false;
+
+  // Entries which haven't been used for a while are most likely for
+  // files which no longer exist.
+  std::map<key, entry>::iterator it = m_entries.begin();
+  while (it != m_entries.end())
+  {
+    if (it->second.used + SSDEEP_CACHE_DAYS < m_today)
+    {
+      m_entries.erase(it++);
+      m_changed = true;
+    }
+    else
+      ++it;
+  }
+
+  if (not m_changed)
+    return false;
+
+  // The new cache is written next to the old one and then renamed over
+  // it, which replaces the file in one step.
+  std::string tmp_fn = m_filename + ".XXXXXX";
+  std::vector<char> tmp_buf(tmp_fn.begin(), tmp_fn.end());
+  tmp_buf.push_back('\0');
+  int fd = mkstemp(&tmp_buf[0]);
+  if (fd < 0)
+    return true;
+
+  FILE * handle = fdopen(fd, "wb");
+  if (NULL == handle)
+  {
+    close(fd);
+    unlink(&tmp_buf[0]);
+    return true;
+  }
+
+  fprintf(handle, "%s\n", CACHE_HEADER);
+  for (it = m_entries.begin() ; it != m_entries.end() ; ++it)
+    fprintf(handle,
+	    "%llu,%llu,%llu,%lld,%lld,%lu,%s\n",
+	    (unsigned long long)it->first.first,
+	    (unsigned long long)it->first.second,
+	    (unsigned long long)it->second.size,
+	    (long long)it->second.mtime,
+	    (long long)it->second.ctime,
+	    (unsigned long)it->second.used,
+	    it->second.sum.c_str());
+
+  bool error = (fflush(handle) != 0 or fsync(fd) != 0);
+  if (fclose(handle) != 0)
+    error = true;
+  if (not error and rename(&tmp_buf[0], m_filename.c_str()) != 0)
+    error = true;
+  if (error)
+  {
+    int saved = errno;
+    unlink(&tmp_buf[0]);
+    errno = saved;
+    return true;
+  }
+
+  m_changed = false;
+  return false;
+}
+
+
+bool HashCache::lookup(const struct stat& sb, char *sum)
+{
+  bool found = false;
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&m_lock);
+#endif
+  std::map<key, entry>::iterator it =
+    m_entries.find(key((uint64_t)sb.st_dev, (uint64_t)sb.st_ino));
+  if (it != m_entries.end() and
+      it->second.size  == (uint64_t)sb.st_size and
+      it->second.mtime == (int64_t)sb.st_mtime and
+      it->second.ctime == (int64_t)sb.st_ctime)
+  {
+    strncpy(sum, it->second.sum.c_str(), FUZZY_MAX_RESULT);
+    sum[FUZZY_MAX_RESULT - 1] = 0;
+    if (it->second.used != m_today)
+    {
+      it->second.used = m_today;
+      m_changed = true;
+    }
+    found = true;
+  }
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&m_lock);
+#endif
+
+  return found;
+}
+
+
+void HashCache::store(const struct stat& sb, const char *sum)
+{
+  time_t settled = time(NULL) - CACHE_SETTLE_SECONDS;
+  if (sb.st_mtime > settled or sb.st_ctime > settled)
+    return;
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&m_lock);
+#endif
+  entry& e = m_entries[key((uint64_t)sb.st_dev, (uint64_t)sb.st_ino)];
+  e.size  = (uint64_t)sb.st_size;
+  e.mtime = (int64_t)sb.st_mtime;
+  e.ctime = (int64_t)sb.st_ctime;
+  e.used  = m_today;
+  e.sum   = sum;
+  m_changed = true;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&m_lock);
+#endif
+}
+
+#endif   // ifndef _WIN32
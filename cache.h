@@ -0,0 +1,80 @@
+#ifndef __CACHE_H
+#define __CACHE_H
+
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+#include "main.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+#ifdef HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
+/// @brief Signatures of files hashed by earlier runs, kept in a file
+/// between them.
+///
+/// Entries are found by device and inode, and only used while the size,
+/// modification time and change time of the file are the ones it was
+/// hashed with. Each entry remembers the last day it was used, and
+/// entries which haven't been used for SSDEEP_CACHE_DAYS are dropped
+/// when the cache is saved. The cache can be used by several threads
+/// at once.
+class HashCache
+{
+ public:
+  HashCache();
+  ~HashCache();
+
+  /// @brief Load the cache from fn. A missing file is an empty cache.
+  ///
+  /// @return Returns false on success, true on error
+  bool load(const char *fn);
+
+  /// @brief Write the cache back to the file it was loaded from, if it
+  /// has changed. The new contents replace the old file in one step, so
+  /// an interrupted run never leaves a damaged cache behind.
+  ///
+  /// @return Returns false on success, true on error
+  bool save(void);
+
+  /// @brief Find the signature of the file described by sb.
+  ///
+  /// @return Returns true if the signature was found
+  bool lookup(const struct stat& sb, char *sum);
+
+  /// @brief Remember the signature of the file described by sb, which
+  /// was just hashed.
+  void store(const struct stat& sb, const char *sum);
+
+ private:
+  struct entry
+  {
+    uint64_t size;
+    int64_t mtime;
+    int64_t ctime;
+    /// Day, counted from the epoch, the entry was last used
+    uint32_t used;
+    std::string sum;
+  };
+
+  typedef std::pair<uint64_t,uint64_t> key;
+
+  std::map<key, entry> m_entries;
+  std::string m_filename;
+  uint32_t m_today;
+  bool m_changed;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t m_lock;
+#endif
+};
+
+#endif   // ifndef __CACHE_H
@@ -13,6 +13,12 @@
 
 #include "ssdeep.h"
 
+#ifdef HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+#include <deque>
+#include <vector>
+
 #define STATUS_OK   FALSE
 
 static int is_special_dir(TCHAR *d)
@@ -360,9 +366,489 @@ int process_normal(state *s, TCHAR *fn)
 
   return FALSE;
 }
+
+
+#ifdef HAVE_PTHREAD_H
+
+// ------------------------------------------------------------------
+// PARALLEL TRAVERSAL
+// ------------------------------------------------------------------
+
+// Worker threads walk the directory trees, doing the stat, cycle checks
+// and readdir that process_normal() does. Each entry they find becomes a
+// node in a tree which mirrors the order of the serial walk, and they
+// hash the files they find. The tree holds the results until the main
+// thread, which follows it depth first, displays them in exactly the
+// order process_normal() would have.
+//
+// Each worker has its own queue. It takes the newest entry from its own
+// queue, which keeps it working depth first like the main thread, and
+// when that is empty it steals the oldest entry from another queue. If
+// the main thread gets to an entry nobody has started yet, it processes
+// that entry itself rather than wait.
+
+// Once this many nodes have been found but not yet displayed, the
+// workers stop to let the main thread catch up
+#define WALK_MAX_PENDING  65536
+
+#define WALK_QUEUED   0
+#define WALK_RUNNING  1
+#define WALK_DONE     2
+
+typedef struct walk_node
+{
+  TCHAR * fn;
+  /// The directory this entry is in, or NULL for a command line argument
+  struct walk_node * parent;
+  /// For a directory, its real path, which its descendants must not have
+  TCHAR * real_name;
+
+  int status;
+  /// True while this node is in one of the queues. The main thread may
+  /// take a node out of turn, so it can be finished, or even displayed,
+  /// before a worker gets to it in the queue.
+  bool in_queue;
+  /// True once this node has been displayed and can be freed
+  bool released;
+  /// True if this entry should be hashed
+  bool hash;
+  /// The hash of this entry, once it has been computed
+  hash_result * result;
+  /// errno of the error to display for this entry, or zero
+  int error;
+  /// Any other error to display for this entry, or NULL
+  const char * message;
+  /// The entries in this directory, in the order they were read
+  std::vector<struct walk_node *> children;
+} walk_node;
+
+
+struct walk_state
+{
+  pthread_mutex_t lock;
+  /// Signalled when there is new work or room to do it
+  pthread_cond_t work;
+  /// Signalled when a node is finished
+  pthread_cond_t done;
+
+  /// One queue per worker, plus one for the main thread
+  std::vector<std::deque<walk_node *> > queues;
+  std::vector<pthread_t> threads;
+  std::vector<walk_node *> roots;
+
+  /// Nodes in the queues which nobody has started
+  size_t queued;
+  /// Nodes which haven't been displayed yet
+  size_t pending;
+  bool finished;
+
+  state *s;
+};
+
+
+typedef struct
+{
+  struct walk_state * w;
+  size_t queue;
+} walk_worker;
+
+
+static walk_node * walk_new_node(const TCHAR *fn, walk_node *parent)
+{
+  walk_node * n = new walk_node;
+  n->fn        = _tcsdup(fn);
+  n->parent    = parent;
+  n->real_name = NULL;
+  n->status    = WALK_QUEUED;
+  n->in_queue  = false;
+  n->released  = false;
+  n->hash      = false;
+  n->result    = NULL;
+  n->error     = 0;
+  n->message   = NULL;
+  return n;
+}
+
+
+static void walk_free_node(walk_node *n)
+{
+  free(n->fn);
+  free(n->real_name);
+  delete n->result;
+  delete n;
+}
+
+
+// Read the entries of the directory n, as process_dir() does
+static void walk_dir(walk_node *n)
+{
+  _TDIR *current_dir;
+  struct _tdirent *entry;
+  TCHAR *new_file;
+
+  n->real_name = (TCHAR *)malloc(sizeof(TCHAR) * SSDEEP_PATH_MAX);
+  if (NULL == n->real_name)
+    internal_error("%s: Out of memory", __progname);
+  if (NULL == realpath(n->fn, n->real_name))
+    n->real_name[0] = 0;
+
+  // The directories being processed are exactly the ancestors of this one
+  for (walk_node *p = n->parent ; p != NULL ; p = p->parent)
+  {
+    if (!_tcsncmp(p->real_name, n->real_name, SSDEEP_PATH_MAX))
+    {
+      n->message = "symlink creates cycle";
+      return;
+    }
+  }
+
+  if ((current_dir = _topendir(n->fn)) == NULL)
+  {
+    n->error = errno;
+    return;
+  }
+
+  new_file = (TCHAR *)malloc(sizeof(TCHAR) * SSDEEP_PATH_MAX);
+  if (NULL == new_file)
+    internal_error("%s: Out of memory", __progname);
+
+  while ((entry = _treaddir(current_dir)) != NULL)
+  {
+    if (is_special_dir(entry->d_name))
+      continue;
+
+    _sntprintf(new_file,SSDEEP_PATH_MAX,_TEXT("%s%c%s"),
+	       n->fn,DIR_SEPARATOR,entry->d_name);
+    n->children.push_back(walk_new_node(new_file, n));
+  }
+
+  free(new_file);
+  _tclosedir(current_dir);
+}
+
+
+// Work out what to do with n, as process_normal() does
+static void walk_entry(state *s, walk_node *n)
+{
+  _tstat_t sb;
+  int type;
+
+  clean_name(s, n->fn);
+
+  if (_lstat(n->fn, &sb))
+  {
+    n->error = errno;
+    return;
+  }
+  type = file_type_helper(sb);
+
+  if (type == file_symlink)
+  {
+    if (_sstat(n->fn, &sb))
+    {
+      n->error = errno;
+      return;
+    }
+    type = file_type_helper(sb);
+
+    if (type != file_directory)
+    {
+      n->hash = true;
+      return;
+    }
+  }
+
+  if (type == file_directory)
+  {
+    if (s->mode & mode_recursive)
+      walk_dir(n);
+    else
+      n->message = "Is a directory";
+    return;
+  }
+
+  if (type != file_unknown)
+    n->hash = true;
+}
+
+
+// Queue the nodes in the queue for q. They go in backwards so that
+// the first one is the next one taken off the back.
+static void walk_queue(struct walk_state *w,
+		       size_t q,
+		       const std::vector<walk_node *>& nodes)
+{
+  std::vector<walk_node *>::const_reverse_iterator it;
+  for (it = nodes.rbegin() ; it != nodes.rend() ; ++it)
+  {
+    (*it)->in_queue = true;
+    w->queues[q].push_back(*it);
+  }
+  w->queued  += nodes.size();
+  w->pending += nodes.size();
+  if (not nodes.empty())
+    pthread_cond_broadcast(&w->work);
+}
+
+
+// Process n, which the caller has claimed, and queue its children.
+// Must be called with the lock held.
+static void walk_run(struct walk_state *w, size_t q, walk_node *n)
+{
+  pthread_mutex_unlock(&w->lock);
+  walk_entry(w->s, n);
+  if (n->hash)
+  {
+    n->result = new hash_result;
+    n->error  = hash_file_result(w->s, n->fn, n->result);
+  }
+  pthread_mutex_lock(&w->lock);
+
+  walk_queue(w, q, n->children);
+  n->status = WALK_DONE;
+  pthread_cond_broadcast(&w->done);
+}
+
+
+// Take the next node for the worker with queue q: the newest from its
+// own queue, or the oldest from another. Nodes the main thread has
+// already claimed are dropped along the way, and freed if they have
+// been displayed. Must be called with the lock held and w->queued
+// above zero.
+static walk_node * walk_take(struct walk_state *w, size_t q)
+{
+  for (size_t i = 0 ; i < w->queues.size() ; ++i)
+  {
+    std::deque<walk_node *>& d = w->queues[(q + i) % w->queues.size()];
+    while (not d.empty())
+    {
+      walk_node * n;
+      if (0 == i)
+      {
+	n = d.back();
+	d.pop_back();
+      }
+      else
+      {
+	n = d.front();
+	d.pop_front();
+      }
+      n->in_queue = false;
+      if (WALK_QUEUED == n->status)
+	return n;
+      if (n->released)
+	walk_free_node(n);
+    }
+  }
+
+  return NULL;
+}
+
+
+static void * walk_worker_thread(void *arg)
+{
+  walk_worker * me = (walk_worker *)arg;
+  struct walk_state * w = me->w;
+
+  pthread_mutex_lock(&w->lock);
+  while (true)
+  {
+    while (not w->finished and
+	   (0 == w->queued or w->pending > WALK_MAX_PENDING))
+      pthread_cond_wait(&w->work, &w->lock);
+    if (w->finished)
+      break;
+
+    walk_node * n = walk_take(w, me->queue);
+    if (NULL == n)
+      internal_error("%s: Lost track of queued files", __progname);
+    n->status = WALK_RUNNING;
+    w->queued--;
+    walk_run(w, me->queue, n);
+  }
+  pthread_mutex_unlock(&w->lock);
+
+  delete me;
+  return NULL;
+}
+
+
+// Wait until n has been processed, processing it on this thread if
+// no worker has started it yet
+static void walk_wait(struct walk_state *w, walk_node *n)
+{
+  pthread_mutex_lock(&w->lock);
+  if (WALK_QUEUED == n->status)
+  {
+    n->status = WALK_RUNNING;
+    w->queued--;
+    walk_run(w, 0, n);
+  }
+  while (n->status != WALK_DONE)
+    pthread_cond_wait(&w->done, &w->lock);
+  pthread_mutex_unlock(&w->lock);
+}
+
+
+// Display the results for n, once it's ready
+static void walk_display(state *s, walk_node *n)
+{
+  walk_wait(s->walker, n);
+
+  if (n->error)
+    print_error_unicode(s, n->fn, "%s", strerror(n->error));
+  else if (n->message)
+    print_error_unicode(s, n->fn, "%s", n->message);
+  else if (n->hash)
+  {
+    display_hashing_status(s, n->fn);
+    display_hash_result(s, n->fn, n->result);
+  }
+}
+
+
+// Free n once it and everything below it have been displayed
+static void walk_release(struct walk_state *w, walk_node *n)
+{
+  pthread_mutex_lock(&w->lock);
+  // Whoever takes it out of the queue frees it then
+  if (n->in_queue)
+    n->released = true;
+  else
+    walk_free_node(n);
+  if (w->pending-- == WALK_MAX_PENDING + 1)
+    pthread_cond_broadcast(&w->work);
+  pthread_mutex_unlock(&w->lock);
+}
+
+
+int process_parallel(state *s, TCHAR *fn)
+{
+  if (NULL == s or NULL == fn)
+    return TRUE;
+
+  struct walk_state * w = s->walker;
+  if (NULL == w)
+  {
+    w = new walk_state;
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->work, NULL);
+    pthread_cond_init(&w->done, NULL);
+    w->queues.resize(s->threads + 1);
+    w->queued   = 0;
+    w->pending  = 0;
+    w->finished = false;
+    w->s        = s;
+    s->walker   = w;
+
+    for (size_t i = 1 ; i <= s->threads ; ++i)
+    {
+      walk_worker * me = new walk_worker;
+      me->w     = w;
+      me->queue = i;
+      pthread_t t;
+      if (pthread_create(&t, NULL, walk_worker_thread, me))
+      {
+	// The main thread can do everything on its own if need be
+	delete me;
+	break;
+      }
+      w->threads.push_back(t);
+    }
+  }
+
+  std::vector<walk_node *> root(1, walk_new_node(fn, NULL));
+  w->roots.push_back(root[0]);
+
+  pthread_mutex_lock(&w->lock);
+  walk_queue(w, 0, root);
+  pthread_mutex_unlock(&w->lock);
+
+  return FALSE;
+}
+
+
+void process_parallel_done(state *s)
+{
+  if (NULL == s or NULL == s->walker)
+    return;
+
+  struct walk_state * w = s->walker;
+
+  // Follow the trees depth first, freeing each node after everything
+  // below it has been displayed. Nodes still being walked refer to
+  // their ancestors.
+  std::vector<std::pair<walk_node *, size_t> > stack;
+  std::vector<walk_node *>::const_iterator it;
+  for (it = w->roots.begin() ; it != w->roots.end() ; ++it)
+  {
+    walk_display(s, *it);
+    stack.push_back(std::make_pair(*it, (size_t)0));
+
+    while (not stack.empty())
+    {
+      walk_node * n = stack.back().first;
+      size_t i = stack.back().second++;
+      if (i < n->children.size())
+      {
+	walk_display(s, n->children[i]);
+	stack.push_back(std::make_pair(n->children[i], (size_t)0));
+      }
+      else
+      {
+	stack.pop_back();
+	walk_release(w, n);
+      }
+    }
+  }
+
+  pthread_mutex_lock(&w->lock);
+  w->finished = true;
+  pthread_cond_broadcast(&w->work);
+  pthread_mutex_unlock(&w->lock);
+
+  std::vector<pthread_t>::const_iterator t;
+  for (t = w->threads.begin() ; t != w->threads.end() ; ++t)
+    pthread_join(*t, NULL);
+
+  // Anything left in the queues was taken out of turn and displayed
+  std::vector<std::deque<walk_node *> >::const_iterator q;
+  std::deque<walk_node *>::const_iterator qn;
+  for (q = w->queues.begin() ; q != w->queues.end() ; ++q)
+    for (qn = q->begin() ; qn != q->end() ; ++qn)
+      walk_free_node(*qn);
+
+  pthread_cond_destroy(&w->done);
+  pthread_cond_destroy(&w->work);
+  pthread_mutex_destroy(&w->lock);
+  delete w;
+  s->walker = NULL;
+}
+
+#endif   // ifdef HAVE_PTHREAD_H
 #endif   // ifndef _WIN32
 
 
+#if defined(_WIN32) || !defined(HAVE_PTHREAD_H)
+
+// Without threads, everything is processed as it's found
+int process_parallel(state *s, TCHAR *fn)
+{
+#ifdef _WIN32
+  return process_win32(s, fn);
+#else
+  return process_normal(s, fn);
+#endif
+}
+
+
+void process_parallel_done(state *s)
+{
+}
+
+#endif
+
+
 int process_stdin(state *s)
 {
   if (NULL == s)
@@ -11,6 +11,8 @@
  * Copyright (C) 2014 Jesse Kornblum <research@jessekornblum.com>
  */
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
 
 #define EDIT_DISTN_MAXLEN 64 /* MAX_SPAMSUM */
 #define EDIT_DISTN_INSERT_COST 1
@@ -42,6 +44,80 @@ int edit_distn(const char *s1, size_t s1len, const char *s2, size_t s2len) {
   return t1[s2len];
 }
 
+// Number of set bits in x
+static int popcount64(uint64_t x) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(x);
+#else
+  int n = 0;
+  for ( ; x ; x &= x - 1)
+    n++;
+  return n;
+#endif
+}
+
+// Since replacing a character costs the same as removing it and inserting
+// another one, the edit distance is s1len + s2len - 2 * LCS(s1, s2). The
+// longest common subsequence is computed with the bit-parallel algorithm
+// of Allison and Dix (as formulated by Hyyro), which keeps one bit per
+// character of s1 and so handles a whole signature part in a single
+// 64-bit word for each character of s2.
+int edit_distn_bp_max(const char *s1, size_t s1len,
+		      const char *s2, size_t s2len,
+		      int max_dist) {
+  uint64_t pm[256];
+  uint64_t v, u, mask;
+  size_t i;
+  int need;
+
+  if (s1len > EDIT_DISTN_MAXLEN) {
+    if (s2len > EDIT_DISTN_MAXLEN)
+      return edit_distn(s1, s1len, s2, s2len);
+    // The distance is symmetric
+    return edit_distn_bp_max(s2, s2len, s1, s1len, max_dist);
+  }
+  if (0 == s1len || 0 == s2len)
+    return (int)(s1len * EDIT_DISTN_REMOVE_COST +
+		 s2len * EDIT_DISTN_INSERT_COST);
+
+  // The LCS can be no longer than the shorter string, so the distance
+  // is at least the difference in lengths
+  if (max_dist < (int)(s1len > s2len ? s1len - s2len : s2len - s1len))
+    return max_dist + 1;
+  // The shortest LCS which keeps the distance within max_dist
+  need = ((int)(s1len + s2len) - max_dist + 1) / 2;
+
+  mask = (s1len == 64) ? ~(uint64_t)0 : (((uint64_t)1 << s1len) - 1);
+
+  // Only clear the entries we are going to look at. This is much cheaper
+  // than clearing the whole table for strings this short.
+  for (i = 0; i < s2len; i++)
+    pm[(unsigned char)s2[i]] = 0;
+  for (i = 0; i < s1len; i++)
+    pm[(unsigned char)s1[i]] = 0;
+  for (i = 0; i < s1len; i++)
+    pm[(unsigned char)s1[i]] |= (uint64_t)1 << i;
+
+  v = ~(uint64_t)0;
+  for (i = 0; i < s2len; i++) {
+    u = v & pm[(unsigned char)s2[i]];
+    v = (v + u) | (v - u);
+
+    // Every remaining character of s2 can add at most one to the LCS.
+    // Check every so often whether we can still get there.
+    if ((i & 7) == 7 &&
+	popcount64(~v & mask) + (int)(s2len - i - 1) < need)
+      return max_dist + 1;
+  }
+
+  // Each zero bit in the low s1len bits of v is one character of the LCS
+  return (int)(s1len + s2len) - 2 * popcount64(~v & mask);
+}
+
+int edit_distn_bp(const char *s1, size_t s1len, const char *s2, size_t s2len) {
+  return edit_distn_bp_max(s1, s1len, s2, s2len, INT_MAX);
+}
+
 
 #ifdef __UNITTEST
 #include <stdio.h>
@@ -78,6 +154,52 @@ int run_test(char *a, char *b, int expected, char *msg) {
 
 #define RUN_TEST(A,B,EXPECTED,MSG)   failures += run_test(A,B,EXPECTED,MSG)
 
+// Compares edit_distn_bp against edit_distn on random strings of every
+// length up to EDIT_DISTN_MAXLEN. A small alphabet makes long common
+// subsequences likely. Returns the number of mismatches.
+unsigned int run_random_tests(unsigned int rounds, unsigned int alphabet) {
+  char a[EDIT_DISTN_MAXLEN], b[EDIT_DISTN_MAXLEN];
+  unsigned int failures = 0, r;
+  size_t a_len, b_len, i;
+
+  for (r = 0; r < rounds; r++) {
+    a_len = rand() % (EDIT_DISTN_MAXLEN + 1);
+    b_len = rand() % (EDIT_DISTN_MAXLEN + 1);
+    for (i = 0; i < a_len; i++)
+      a[i] = 'A' + rand() % alphabet;
+    for (i = 0; i < b_len; i++)
+      b[i] = 'A' + rand() % alphabet;
+
+    int expected = edit_distn(a, a_len, b, b_len);
+    int actual = edit_distn_bp(a, a_len, b, b_len);
+    if (actual != expected) {
+      printf ("FAIL: Expected %d, got %d for %.*s:%.*s, bit-parallel\n",
+	      expected,
+	      actual,
+	      (int)a_len, a,
+	      (int)b_len, b);
+      failures++;
+    }
+
+    // With a limit, the distance must be exact up to the limit and
+    // anything above it otherwise.
+    int max_dist = rand() % (EDIT_DISTN_MAXLEN * 2 + 1);
+    actual = edit_distn_bp_max(a, a_len, b, b_len, max_dist);
+    if ((expected <= max_dist && actual != expected) ||
+	(expected > max_dist && actual <= max_dist)) {
+      printf ("FAIL: Expected %d, got %d with limit %d for %.*s:%.*s\n",
+	      expected,
+	      actual,
+	      max_dist,
+	      (int)a_len, a,
+	      (int)b_len, b);
+      failures++;
+    }
+  }
+
+  return failures;
+}
+
 int main(void) {
   unsigned int failures = 0;
 
@@ -91,6 +213,10 @@ int main(void) {
   RUN_TEST("Hello world", "Hello owrld", 2, "Swap");
   RUN_TEST("Hello world", "HellX world", 2, "Change");
 
+  srand(1);
+  failures += run_random_tests(100000, 4);
+  failures += run_random_tests(100000, 64);
+
   if (failures) {
     printf ("\n%u tests failed.\n", failures);
     return EXIT_FAILURE;
@@ -3,10 +3,32 @@
 #include "main.h"
 #include "ssdeep.h"
 #include "match.h"
+#include "server.h"
+
+#ifdef HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
 
 #define MAX_STATUS_MSG   78
 
-bool display_result(state *s, const TCHAR * fn, const char * sum) {
+// The libfuzzy hashing functions give each thread at least this much of
+// a file, so smaller files don't need any more threads
+#define MIN_SEGMENT_SIZE ((uint64_t)16 << 20)
+
+bool display_result(state *s, 
+		    const TCHAR * fn, 
+		    const char * sum,
+		    const hash_result * r) {
+#ifndef _WIN32
+  // A match server does the matching for us
+  if (NULL != s->client) {
+    if (client_query(s, fn, sum))
+      fatal_error("%s: Unable to query the match server: %s", 
+		  __progname, strerror(errno));
+    return false;
+  }
+#endif
+
   // Only spend the extra time to make a Filedata object if we need to
   if (MODE(mode_match_pretty) or MODE(mode_match) or MODE(mode_directory)) {
     Filedata * f;
@@ -24,18 +46,23 @@ bool display_result(state *s, const TCHAR * fn, const char * sum) {
     }
     else {
       // This block is for MODE(mode_match) or MODE(mode_directory)
-      match_compare(s, f);
+      if (NULL != r and r->scored)
+	match_report(s, f, r->scores);
+      else if (not s->deferred_directory)
+	match_compare(s, f);
       
       if (MODE(mode_directory)) {
 	if (match_add(s, f))
 	  print_error_unicode(s,
 			      fn,
 			      "Unable to add hash to set of known hashes");
-      } else {
-	// We haven't add f to the set of knowns, so let's free it.
-	delete f;
       }
     }
+
+    // The set of knowns keeps its own copy of f. Unless f is in a
+    // cluster, which still needs it, we're done with it.
+    if (not f->has_cluster())
+      delete f;
   }
   else
   {
@@ -55,15 +82,136 @@ bool display_result(state *s, const TCHAR * fn, const char * sum) {
 }
 
 
-int hash_file(state *s, TCHAR *fn) {
-  size_t fn_length;
-  char *sum;
-  TCHAR *my_filename, *msg;
-  FILE *handle;
+// True if the file can be compared to the knowns as soon as it's
+// hashed. That's only when the knowns are fixed, not when each file
+// is added to them.
+static bool can_score_early(const state *s)
+{
+  return (MODE(mode_match) and 
+	  not MODE(mode_match_pretty) and 
+	  not MODE(mode_directory));
+}
+
+
+// Threads busy hashing files, counting the ones a large file was split
+// between. The threads walking directories each hash files, so they
+// share the -j threads rather than each starting that many more.
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t hash_threads_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static unsigned int hash_threads_busy = 0;
+
+// Returns the number of threads to hash a file of the given size with,
+// which are given back with put_hash_threads(). The calling thread is
+// always one of them, even if the others have taken all of the threads.
+static unsigned int get_hash_threads(const state *s, uint64_t size)
+{
+  uint64_t wanted = size / MIN_SEGMENT_SIZE;
+  if (wanted > s->threads)
+    wanted = s->threads;
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&hash_threads_lock);
+#endif
+  uint64_t spare = 0;
+  if (hash_threads_busy < s->threads)
+    spare = s->threads - hash_threads_busy;
+  unsigned int threads = (unsigned int)((wanted < spare) ? wanted : spare);
+  if (threads < 1)
+    threads = 1;
+  hash_threads_busy += threads;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&hash_threads_lock);
+#endif
+
+  return threads;
+}
+
+
+static void put_hash_threads(unsigned int threads)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&hash_threads_lock);
+#endif
+  hash_threads_busy -= threads;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_unlock(&hash_threads_lock);
+#endif
+}
+
+
+// Hash a file which can only be read through stdio
+static int hash_handle(const state *s, FILE *handle, hash_result *r)
+{
+  if (NULL == handle)
+    return errno;
+
+  off_t size = find_file_size(handle);
+  unsigned int threads = get_hash_threads(s, (uint64_t)size);
+  errno = 0;
+  int status = fuzzy_hash_file_parallel(handle, threads, r->sum);
+  int error = errno ? errno : EIO;
+  put_hash_threads(threads);
+  if (status) {
+    fclose(handle);
+    return error;
+  }
+  r->meaningful = (size > SSDEEP_MIN_FILE_SIZE);
+  fclose(handle);
+  return 0;
+}
+
+
+#ifndef WIN32
+// Open and hash fn. Regular files are hashed straight from the
+// descriptor, using the size fstat already gave us. Devices and the
+// like go through stdio, as find_file_size() needs.
+static int hash_fd(const state *s, const TCHAR *fn, hash_result *r)
+{
+  struct stat sb;
+  int fd = open(fn, O_RDONLY);
+  if (fd < 0)
+    return errno;
+  if (fstat(fd, &sb)) {
+    int error = errno;
+    close(fd);
+    return error;
+  }
+
+  if (S_ISREG(sb.st_mode)) {
+    unsigned int threads = get_hash_threads(s, (uint64_t)sb.st_size);
+    // Files can change while we hash them, so they aren't mapped
+    errno = 0;
+    int status = fuzzy_hash_fd(fd, (uint_least64_t)sb.st_size, threads,
+			       r->sum, 0);
+    int error = errno ? errno : EIO;
+    put_hash_threads(threads);
+    if (status) {
+      close(fd);
+      return error;
+    }
+    r->meaningful = (sb.st_size > SSDEEP_MIN_FILE_SIZE);
+    close(fd);
+    if (NULL != s->cache)
+      s->cache->store(sb, r->sum);
+    return 0;
+  }
+
+  FILE *handle = fdopen(fd, "rb");
+  if (NULL == handle) {
+    int error = errno;
+    close(fd);
+    return error;
+  }
+  return hash_handle(s, handle, r);
+}
+#endif
 
+
+int hash_file_result(const state *s, const TCHAR *fn, hash_result *r) {
 #ifdef WIN32  
   TCHAR expanded_fn[SSDEEP_PATH_MAX];
-  if (not expanded_path(fn)) {
+  if (not expanded_path((TCHAR *)fn)) {
     _sntprintf(expanded_fn, 
 	       SSDEEP_PATH_MAX,
 	       _TEXT("\\\\?\\%s"), 
@@ -71,67 +219,87 @@ int hash_file(state *s, TCHAR *fn) {
   } else {
     _tcsncpy(expanded_fn, fn, SSDEEP_PATH_MAX);
   }
-  handle = _tfopen(expanded_fn, _TEXT("rb"));
+  int error = hash_handle(s, _tfopen(expanded_fn, _TEXT("rb")), r);
+  if (error)
+    return error;
 # else
-  handle = fopen(fn, "rb");
+  // A file which hasn't changed since the cache saw it isn't even opened
+  struct stat sb;
+  if (NULL != s->cache and 
+      0 == stat(fn, &sb) and 
+      S_ISREG(sb.st_mode) and
+      s->cache->lookup(sb, r->sum))
+    r->meaningful = (sb.st_size > SSDEEP_MIN_FILE_SIZE);
+  else {
+    int error = hash_fd(s, fn, r);
+    if (error)
+      return error;
+  }
 #endif
 
-  if (NULL == handle)
-  {
-    print_error_unicode(s,fn,"%s", strerror(errno));
-    return TRUE;
-  }
- 
-  if ((sum = (char *)malloc(sizeof(char) * FUZZY_MAX_RESULT)) == NULL)
-  {
-    fclose(handle);
-    print_error_unicode(s,fn,"%s", strerror(errno));
-    return TRUE;
+  r->scored = false;
+  if (can_score_early(s)) {
+    struct fuzzy_parsed_digest d;
+    if (not fuzzy_parse_digest(&d, r->sum)) {
+      match_score(s, d, r->scores);
+      r->scored = true;
+    }
   }
 
-  if ((msg = (TCHAR *)malloc(sizeof(TCHAR) * (MAX_STATUS_MSG + 2))) == NULL)
-  {
-    free(sum);
-    fclose(handle);
-    print_error_unicode(s,fn,"%s", strerror(errno));
-    return TRUE;
-  }
+  return 0;
+}
 
-  if (MODE(mode_verbose))
-  {
-    fn_length = _tcslen(fn);
-    if (fn_length > MAX_STATUS_MSG)
-    {
-      // We have to make a duplicate of the string to call basename on it
-      // We need the original name for the output later on
-      my_filename = _tcsdup(fn);
-      my_basename(my_filename);
-    }
-    else
-      my_filename = fn;
-
-    _sntprintf(msg,
-	       MAX_STATUS_MSG-1,
-	       _TEXT("Hashing: %s%s"), 
-	       my_filename, 
-	       _TEXT(BLANK_LINE));
-    _ftprintf(stderr,_TEXT("%s\r"), msg);
-
-    if (fn_length > MAX_STATUS_MSG)
-      free(my_filename);
-  }
 
-  fuzzy_hash_file(handle,sum);
+bool display_hash_result(state *s, TCHAR *fn, const hash_result *r) {
   prepare_filename(s,fn);
-  display_result(s,fn,sum);
+  display_result(s,fn,r->sum,r);
 
-  if (find_file_size(handle) > SSDEEP_MIN_FILE_SIZE)
+  if (r->meaningful)
     s->found_meaningful_file = true;
   s->processed_file = true;
 
-  fclose(handle);
-  free(sum);
-  free(msg);
-  return FALSE;
+  return false;
+}
+
+
+void display_hashing_status(state *s, const TCHAR *fn) {
+  const TCHAR *my_filename = fn;
+  TCHAR msg[MAX_STATUS_MSG + 2];
+
+  if (not MODE(mode_verbose))
+    return;
+
+  // Long names are shortened to their basename, which is the part
+  // after the last separator. It's found in place, as the original
+  // name is needed for the output later on.
+  if (_tcslen(fn) > MAX_STATUS_MSG)
+  {
+    const TCHAR *base = _tcsrchr(fn, DIR_SEPARATOR);
+    if (NULL != base)
+      my_filename = base + 1;
+  }
+
+  _sntprintf(msg,
+	     MAX_STATUS_MSG-1,
+	     _TEXT("Hashing: %s%s"), 
+	     my_filename, 
+	     _TEXT(BLANK_LINE));
+  _ftprintf(stderr,_TEXT("%s\r"), msg);
 }
 
+
+int hash_file(state *s, TCHAR *fn) {
+  hash_result r;
+
+  display_hashing_status(s,fn);
+
+  int error = hash_file_result(s,fn,&r);
+  if (error)
+  {
+    print_error_unicode(s,fn,"%s", strerror(error));
+    return TRUE;
+  }
+
+  display_hash_result(s,fn,&r);
+  return FALSE;
+}
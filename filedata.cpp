@@ -12,7 +12,7 @@
 #include <string.h>
 
 
-bool Filedata::valid(void) const
+bool Filedata::valid(void)
 {
   // A valid fuzzy hash has the form
   // [blocksize]:[sig1]:[sig2]
@@ -40,19 +40,7 @@ bool Filedata::valid(void) const
   if (sig)
     return false;
 
-  return true;
-}
-
-
-void Filedata::clear_cluster(void)
-{
-  if (NULL == m_cluster)
-    return;
-
-  // We don't want to call the destructors on the individual elements
-  // so we have to clear the set first.
-  m_cluster->clear();
-  m_cluster = NULL;
+  return (0 == fuzzy_parse_digest_lenient(&m_digest, m_signature.c_str()));
 }
 
 
@@ -63,7 +51,7 @@ Filedata::Filedata(const TCHAR * fn, const char * sig, const char * match_file)
     throw std::bad_alloc();
 
   m_filename = _tcsdup(fn);
-  m_cluster  = NULL;
+  m_cluster  = NO_CLUSTER;
 
   if (NULL == match_file)
     m_has_match_file = false;
@@ -78,7 +66,7 @@ Filedata::Filedata(const TCHAR * fn, const char * sig, const char * match_file)
 Filedata::Filedata(const std::string& sig, const char * match_file)
 {
   // Set the easy stuff first
-  m_cluster = NULL;
+  m_cluster = NO_CLUSTER;
 
   if (NULL == match_file)
     m_has_match_file = false;
@@ -123,6 +111,8 @@ Filedata::Filedata(const std::string& sig, const char * match_file)
   // Strip off the filename from the signature. Remember that "start"
   // now points to two characters ahead of the comma
   m_signature = sig.substr(0,start-2);
+  if (fuzzy_parse_digest_lenient(&m_digest, m_signature.c_str()))
+    throw std::bad_alloc();
 
   // Unescape any quotation marks in the filename
   while (tmp.find(std::string("\\\"")) != std::string::npos)
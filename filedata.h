@@ -12,6 +12,10 @@
 #include <stdlib.h>
 #include <assert.h>
 #include "tchar-local.h"
+#include "fuzzy.h"
+
+/// Value of Filedata::get_cluster() for a file which isn't in a cluster
+#define NO_CLUSTER  UINT32_MAX
 
 /// Contains a fuzzy hash and associated metadata for file
 class Filedata
@@ -31,7 +35,11 @@ class Filedata
 
   /// Returns the file's fuzzy hash without a filename.
   /// std::string("[blocksize]:[sig1]:[sig2]")
-  std::string get_signature(void) const { return m_signature; }
+  const std::string& get_signature(void) const { return m_signature; }
+
+  /// Returns the file's fuzzy hash split into its parts, ready to be
+  /// passed to fuzzy_compare_digest()
+  const struct fuzzy_parsed_digest& get_digest(void) const { return m_digest; }
 
   /// Returns the file's name
   /// RBF - Should this be a std::wstring?
@@ -41,26 +49,29 @@ class Filedata
   bool has_match_file(void) const { return m_has_match_file; }
   /// Returns the name of the file on the disk from which this file came
   /// RBF - Should this be a std::wstring?
-  std::string get_match_file(void) const { return m_match_file; }
+  const std::string& get_match_file(void) const { return m_match_file; }
 
   /// Returns true if this file belongs to a cluster of similar files
-  bool has_cluster(void) const { return (m_cluster != NULL); }
-  void set_cluster(std::set<Filedata *> *c) { m_cluster = c; }
-  std::set<Filedata* >* get_cluster(void) const { return m_cluster; }
-  void clear_cluster(void);
+  bool has_cluster(void) const { return (m_cluster != NO_CLUSTER); }
+  /// Records the node for this file in the disjoint sets of clusters
+  void set_cluster(uint32_t node) { m_cluster = node; }
+  uint32_t get_cluster(void) const { return m_cluster; }
 
   ~Filedata() { if (m_filename) { free(m_filename); } }
 
  private:
   Filedata(const Filedata &other) { assert(false); /* never copy */ }
 
-  std::set<Filedata *> * m_cluster;
+  uint32_t m_cluster;
 
   /// Original signature in the form [blocksize]:[sig1]:[sig2]
   /// It may also contain the filename, but there is no guarantee of that
   /// one way or the other.
   std::string m_signature;
 
+  /// m_signature parsed once so comparisons don't have to
+  struct fuzzy_parsed_digest m_digest;
+
   /// RBF - Should this be a std::wstring?
   TCHAR * m_filename;
 
@@ -68,8 +79,9 @@ class Filedata
   std::string m_match_file;
   bool m_has_match_file;
 
-  /// Returns true if the m_signature field contains a valid fuzzy hash
-  bool valid(void) const;
+  /// Returns true if the m_signature field contains a valid fuzzy hash.
+  /// Also fills in m_digest.
+  bool valid(void);
 };
 
 
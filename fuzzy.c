@@ -34,6 +34,20 @@
 
 #include "fuzzy.h"
 #include "edit_dist.h"
+#include "sum_table.h"
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #if defined(__GNUC__) && __GNUC__ >= 3
 #define likely(x)       __builtin_expect(!!(x), 1)
@@ -47,6 +61,8 @@
 #define MIN_BLOCKSIZE 3
 #define HASH_PRIME 0x01000193
 #define HASH_INIT 0x28021967
+/* Only the low six bits of the FNV hashes are kept, see sum_table.h */
+#define HASH_INIT6 (HASH_INIT % 64)
 #define NUM_BLOCKHASHES 31
 
 struct roll_state {
@@ -94,20 +110,129 @@ static uint32_t roll_sum(const struct roll_state *self)
   return self->h1 + self->h2 + self->h3;
 }
 
-/* A simple non-rolling hash, based on the FNV hash. */
+/* Store a rolling hash which was kept outside of self while buffer was
+ * fed to it up to end, with at least ROLLING_WINDOW bytes read from the
+ * buffer. The window was at position start when the buffer began. */
+static void roll_sync(struct roll_state *self,
+		      uint32_t h1, uint32_t h2, uint32_t h3,
+		      const unsigned char *buffer,
+		      size_t end,
+		      size_t start)
+{
+  size_t j;
+  self->h1 = h1;
+  self->h2 = h2;
+  self->h3 = h3;
+  for (j = end - ROLLING_WINDOW; j < end; ++j)
+    self->window[(start + j) % ROLLING_WINDOW] = buffer[j];
+  self->n = (uint32_t)((start + end) % ROLLING_WINDOW);
+}
+
+/* A simple non-rolling hash, based on the FNV hash. Only the low six
+ * bits are ever used, so only those are computed. */
 static uint32_t sum_hash(unsigned char c, uint32_t h)
 {
-  return (h * HASH_PRIME) ^ c;
+  return sum_table[c & 0x3f][h];
+}
+
+/* The FNV hashes of all blockhashes are updated for every byte, so they are
+ * kept side by side where they can be updated a vector at a time. The vector
+ * code reads and writes whole vectors from the first active blockhash, so
+ * the array is padded by a vector's worth. */
+#if defined(__AVX2__)
+#define FNV_VECTOR 32
+#elif defined(__SSE2__)
+#define FNV_VECTOR 16
+#else
+#define FNV_VECTOR 1
+#endif
+#define FNV_LANES (2 * NUM_BLOCKHASHES + FNV_VECTOR)
+
+/* The h and halfh hashes of blockhash i */
+#define FNV_H(self, i) ((self)->fnv[2 * (i)])
+#define FNV_HALFH(self, i) ((self)->fnv[2 * (i) + 1])
+
+#if FNV_VECTOR > 1
+/* The low six bits of h * HASH_PRIME are those of h * 19, which can be
+ * computed for a whole vector of hashes as h * 16 + h * 3. There is no
+ * byte shift, so h * 16 is a 16-bit shift with the bits which crossed
+ * into the next byte masked off. */
+#if defined(__AVX2__)
+typedef __m256i fnv_vector;
+#define fnv_load(p) _mm256_loadu_si256((const __m256i *)(p))
+#define fnv_store(p, v) _mm256_storeu_si256((__m256i *)(p), (v))
+#define fnv_set1(c) _mm256_set1_epi8((char)(c))
+#define fnv_add(a, b) _mm256_add_epi8((a), (b))
+#define fnv_xor(a, b) _mm256_xor_si256((a), (b))
+#define fnv_and(a, b) _mm256_and_si256((a), (b))
+#define fnv_shl4(a) _mm256_slli_epi16((a), 4)
+/* Half vectors, for hashing two streams in one */
+#define fnv_half_load(p) \
+  _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(p)))
+#define fnv_half_store(p, v) \
+  _mm_storeu_si128((__m128i *)(p), _mm256_castsi256_si128(v))
+#define fnv_half_store_high(p, v) \
+  _mm_storeu_si128((__m128i *)(p), _mm256_extracti128_si256((v), 1))
+#define fnv_pair(lo, hi) \
+  _mm256_inserti128_si256((lo), _mm256_castsi256_si128(hi), 1)
+#define fnv_set2(a, b) \
+  _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi8((char)(a))), \
+			  _mm_set1_epi8((char)(b)), 1)
+#else
+typedef __m128i fnv_vector;
+#define fnv_load(p) _mm_loadu_si128((const __m128i *)(p))
+#define fnv_store(p, v) _mm_storeu_si128((__m128i *)(p), (v))
+#define fnv_set1(c) _mm_set1_epi8((char)(c))
+#define fnv_add(a, b) _mm_add_epi8((a), (b))
+#define fnv_xor(a, b) _mm_xor_si128((a), (b))
+#define fnv_and(a, b) _mm_and_si128((a), (b))
+#define fnv_shl4(a) _mm_slli_epi16((a), 4)
+#define fnv_half_load(p) _mm_loadl_epi64((const __m128i *)(p))
+#define fnv_half_store(p, v) _mm_storel_epi64((__m128i *)(p), (v))
+#define fnv_half_store_high(p, v) \
+  _mm_storel_epi64((__m128i *)(p), _mm_unpackhi_epi64((v), (v)))
+#define fnv_pair(lo, hi) _mm_unpacklo_epi64((lo), (hi))
+#define fnv_set2(a, b) fnv_pair(fnv_set1(a), fnv_set1(b))
+#endif
+
+/* Update each hash in h with the byte in the same lane of c */
+static fnv_vector fnv_mix(fnv_vector h, fnv_vector c)
+{
+  fnv_vector h16 = fnv_and(fnv_shl4(h), fnv_set1(0x30));
+  fnv_vector h3 = fnv_add(fnv_add(h, h), h);
+  h = fnv_xor(fnv_add(h16, h3), c);
+  return fnv_and(h, fnv_set1(0x3f));
+}
+
+static fnv_vector fnv_step(fnv_vector h, unsigned char c)
+{
+  return fnv_mix(h, fnv_set1(c));
+}
+#endif
+
+/* Update the hashes in lanes start up to end with c. */
+static void fnv_update(unsigned char *fnv,
+		       unsigned int start,
+		       unsigned int end,
+		       unsigned char c)
+{
+#if FNV_VECTOR > 1
+  for ( ; start < end; start += FNV_VECTOR)
+    fnv_store(fnv + start, fnv_step(fnv_load(fnv + start), c));
+#else
+  for ( ; start < end; ++start)
+    fnv[start] = (unsigned char)sum_hash(c, fnv[start]);
+#endif
 }
 
 /* A blockhash contains a signature state for a specific (implicit) blocksize.
- * The blocksize is given by SSDEEP_BS(index). The h and halfh members are the
- * FNV hashes, where halfh stops to be reset after digest is SPAMSUM_LENGTH/2
- * long. The halfh hash is needed be able to truncate digest for the second
- * output hash to stay compatible with ssdeep output. */
+ * The blocksize is given by SSDEEP_BS(index). Its h and halfh hashes are the
+ * low six bits of the FNV hashes, kept in fuzzy_state, where halfh stops to
+ * be reset after digest is SPAMSUM_LENGTH/2 long. The halfh hash is needed
+ * be able to truncate digest for the second output hash to stay compatible
+ * with ssdeep output. */
 struct blockhash_context
 {
-  uint32_t h, halfh;
   char digest[SPAMSUM_LENGTH];
   char halfdigest;
   unsigned int dindex;
@@ -120,28 +245,34 @@ struct fuzzy_state
   unsigned int bhstart, bhend, bhendlimit;
   unsigned int flags;
   uint32_t lasth;
+  unsigned char fnv[FNV_LANES];
   struct blockhash_context bh[NUM_BLOCKHASHES];
   struct roll_state roll;
 };
 
 #define FUZZY_STATE_NEED_LASTHASH  1u
 #define FUZZY_STATE_SIZE_FIXED     2u
+#define FUZZY_STATE_SIZE_GUESSED   4u
 
 #define SSDEEP_BS(index) (((uint32_t)MIN_BLOCKSIZE) << (index))
 #define SSDEEP_TOTAL_SIZE_MAX \
   ((uint_least64_t)SSDEEP_BS(NUM_BLOCKHASHES-1) * SPAMSUM_LENGTH)
 
-/*@only@*/ /*@null@*/ struct fuzzy_state *fuzzy_new(void)
+size_t fuzzy_state_size(void)
 {
-  struct fuzzy_state *self;
-  if(NULL == (self = malloc(sizeof(struct fuzzy_state))))
-    /* malloc sets ENOMEM */
-    return NULL;
+  return sizeof(struct fuzzy_state);
+}
+
+struct fuzzy_state *fuzzy_init(void *mem)
+{
+  struct fuzzy_state *self = mem;
   self->bhstart = 0;
   self->bhend = 1;
   self->bhendlimit = NUM_BLOCKHASHES - 1;
-  self->bh[0].h = HASH_INIT;
-  self->bh[0].halfh = HASH_INIT;
+  /* Lanes past the active blockhashes are updated too, but never used */
+  memset(self->fnv, 0, sizeof(self->fnv));
+  FNV_H(self, 0) = HASH_INIT6;
+  FNV_HALFH(self, 0) = HASH_INIT6;
   self->bh[0].digest[0] = '\0';
   self->bh[0].halfdigest = '\0';
   self->bh[0].dindex = 0;
@@ -151,6 +282,20 @@ struct fuzzy_state
   return self;
 }
 
+void fuzzy_reset(struct fuzzy_state *state)
+{
+  (void)fuzzy_init(state);
+}
+
+/*@only@*/ /*@null@*/ struct fuzzy_state *fuzzy_new(void)
+{
+  void *mem;
+  if (NULL == (mem = malloc(sizeof(struct fuzzy_state))))
+    /* malloc sets ENOMEM */
+    return NULL;
+  return fuzzy_init(mem);
+}
+
 /*@only@*/ /*@null@*/ struct fuzzy_state *fuzzy_clone(const struct fuzzy_state *state)
 {
   struct fuzzy_state *newstate;
@@ -188,6 +333,35 @@ int fuzzy_set_total_input_length(struct fuzzy_state *state, uint_least64_t total
   return 0;
 }
 
+int fuzzy_guess_blocksize(struct fuzzy_state *state)
+{
+  unsigned int bi = 0;
+  if (!(state->flags & FUZZY_STATE_SIZE_FIXED) || state->total_size != 0)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+  /* The digest starts from the blocksize the input length suggests and
+   * goes down from there while the signature is too short. Each
+   * blockhash comes out the same no matter which one is the first
+   * tracked, so all but that one, the one below it and the one above it
+   * for the second part of the digest, can be skipped. */
+  while ((uint_least64_t)SSDEEP_BS(bi) * SPAMSUM_LENGTH < state->fixed_size)
+    ++bi;
+  if (bi < 2)
+    return 0;
+  --bi;
+  state->flags |= FUZZY_STATE_SIZE_GUESSED;
+  state->bhstart = bi;
+  state->bhend = bi + 1;
+  FNV_H(state, bi) = HASH_INIT6;
+  FNV_HALFH(state, bi) = HASH_INIT6;
+  state->bh[bi].digest[0] = '\0';
+  state->bh[bi].halfdigest = '\0';
+  state->bh[bi].dindex = 0;
+  return 0;
+}
+
 
 static void fuzzy_try_fork_blockhash(struct fuzzy_state *self)
 {
@@ -197,8 +371,8 @@ static void fuzzy_try_fork_blockhash(struct fuzzy_state *self)
   if (self->bhend <= self->bhendlimit)
   {
     nbh = obh + 1;
-    nbh->h = obh->h;
-    nbh->halfh = obh->halfh;
+    FNV_H(self, self->bhend) = FNV_H(self, self->bhend - 1);
+    FNV_HALFH(self, self->bhend) = FNV_HALFH(self, self->bhend - 1);
     nbh->digest[0] = '\0';
     nbh->halfdigest = '\0';
     nbh->dindex = 0;
@@ -208,7 +382,7 @@ static void fuzzy_try_fork_blockhash(struct fuzzy_state *self)
            !(self->flags & FUZZY_STATE_NEED_LASTHASH))
   {
     self->flags |= FUZZY_STATE_NEED_LASTHASH;
-    self->lasth = obh->h;
+    self->lasth = FNV_H(self, self->bhend - 1);
   }
 }
 
@@ -235,28 +409,18 @@ static void fuzzy_try_reduce_blockhash(struct fuzzy_state *self)
 static const char *b64 =
   "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-static void fuzzy_engine_step(struct fuzzy_state *self, unsigned char c)
+/* Emit a signature character for each blockhash which has hit a reset
+ * point, given that h is the rolling hash plus one. The reset points for
+ * blocksize SSDEEP_BS(i) are where h is a multiple of both MIN_BLOCKSIZE
+ * and 1 << i, so a single division rules out most bytes before this is
+ * called, and a mask checks each blocksize. */
+static void fuzzy_engine_reset(struct fuzzy_state *self, uint_least64_t h)
 {
-  size_t h;
   unsigned int i;
-  /* At each character we update the rolling hash and the normal hashes.
-   * When the rolling hash hits a reset value then we emit a normal hash
-   * as a element of the signature and reset the normal hash. */
-  roll_hash(&self->roll, c);
-  h = roll_sum(&self->roll);
-
-  for (i = self->bhstart; i < self->bhend; ++i)
-  {
-    self->bh[i].h = sum_hash(c, self->bh[i].h);
-    self->bh[i].halfh = sum_hash(c, self->bh[i].halfh);
-  }
-  if (self->flags & FUZZY_STATE_NEED_LASTHASH)
-    self->lasth = sum_hash(c, self->lasth);
-
   for (i = self->bhstart; i < self->bhend; ++i)
   {
     /* With growing blocksize almost no runs fail the next test. */
-    if (likely(h % SSDEEP_BS(i) != SSDEEP_BS(i) - 1))
+    if (likely((h & (((uint_least64_t)1 << i) - 1)) != 0))
       /* Once this condition is false for one bs, it is
        * automatically false for all further bs. I.e. if
        * h === -1 (mod 2*bs) then h === -1 (mod bs). */
@@ -269,9 +433,8 @@ static void fuzzy_engine_step(struct fuzzy_state *self, unsigned char c)
       /* First step for this blocksize. Clone next. */
       fuzzy_try_fork_blockhash(self);
     }
-    self->bh[i].digest[self->bh[i].dindex] =
-      b64[self->bh[i].h % 64];
-    self->bh[i].halfdigest = b64[self->bh[i].halfh % 64];
+    self->bh[i].digest[self->bh[i].dindex] = b64[FNV_H(self, i)];
+    self->bh[i].halfdigest = b64[FNV_HALFH(self, i)];
     if (self->bh[i].dindex < SPAMSUM_LENGTH - 1) {
       /* We can have a problem with the tail overflowing. The
        * easiest way to cope with this is to only reset the
@@ -280,9 +443,9 @@ static void fuzzy_engine_step(struct fuzzy_state *self, unsigned char c)
        * last few pieces of the message into a single piece
        * */
       self->bh[i].digest[++(self->bh[i].dindex)] = '\0';
-      self->bh[i].h = HASH_INIT;
+      FNV_H(self, i) = HASH_INIT6;
       if (self->bh[i].dindex < SPAMSUM_LENGTH / 2) {
-	self->bh[i].halfh = HASH_INIT;
+	FNV_HALFH(self, i) = HASH_INIT6;
 	self->bh[i].halfdigest = '\0';
       }
     } else
@@ -290,9 +453,114 @@ static void fuzzy_engine_step(struct fuzzy_state *self, unsigned char c)
   }
 }
 
-int fuzzy_update(struct fuzzy_state *self,
-		 const unsigned char *buffer,
-		 size_t buffer_size) {
+static void fuzzy_engine_step(struct fuzzy_state *self, unsigned char c)
+{
+  uint_least64_t h;
+  /* At each character we update the rolling hash and the normal hashes.
+   * When the rolling hash hits a reset value then we emit a normal hash
+   * as a element of the signature and reset the normal hash. */
+  roll_hash(&self->roll, c);
+  h = (uint_least64_t)roll_sum(&self->roll) + 1;
+
+  fnv_update(self->fnv, 2 * self->bhstart, 2 * self->bhend, c);
+  if (self->flags & FUZZY_STATE_NEED_LASTHASH)
+    self->lasth = sum_hash(c, self->lasth);
+
+  if (unlikely(h % MIN_BLOCKSIZE == 0))
+    fuzzy_engine_reset(self, h);
+}
+
+#if FNV_VECTOR > 1
+/* Whether all the active hashes fit in one vector and nothing else has
+ * to be updated for each byte. */
+static int fuzzy_engine_fast(const struct fuzzy_state *self)
+{
+  return 2 * (self->bhend - self->bhstart) <= FNV_VECTOR &&
+    !(self->flags & FUZZY_STATE_NEED_LASTHASH);
+}
+#endif
+
+/* Feed a buffer through fuzzy_engine_step. The rolling hash only
+ * depends on the last ROLLING_WINDOW bytes. Once they all come from the
+ * buffer, the byte leaving the window is read from the buffer too, and
+ * the rolling hash stays in registers rather than going through its
+ * window for every byte. While all the active hashes fit in one vector,
+ * they stay in a register as well, between the reset points of the
+ * smallest blocksize. */
+static void fuzzy_engine_run(struct fuzzy_state *self,
+			     const unsigned char *buffer,
+			     size_t buffer_size)
+{
+  uint32_t h1, h2, h3, sum;
+  unsigned char c;
+  size_t j, start = self->roll.n;
+#if FNV_VECTOR > 1
+  fnv_vector v;
+  unsigned int lane;
+  uint32_t mask;
+#endif
+
+  for (j = 0; j < buffer_size && j < ROLLING_WINDOW; ++j)
+    fuzzy_engine_step(self, buffer[j]);
+  if (j == buffer_size)
+    return;
+
+  h1 = self->roll.h1;
+  h2 = self->roll.h2;
+  h3 = self->roll.h3;
+  while (j < buffer_size)
+  {
+#if FNV_VECTOR > 1
+    mask = ((uint32_t)1 << self->bhstart) - 1;
+    lane = 2 * self->bhstart;
+    if (fuzzy_engine_fast(self))
+    {
+      v = fnv_load(self->fnv + lane);
+      do
+      {
+	c = buffer[j];
+	h2 -= h1;
+	h2 += ROLLING_WINDOW * (uint32_t)c;
+	h1 += (uint32_t)c;
+	h1 -= (uint32_t)buffer[j - ROLLING_WINDOW];
+	h3 <<= 5;
+	h3 ^= c;
+	v = fnv_step(v, c);
+	sum = h1 + h2 + h3;
+	++j;
+	/* Should sum + 1 wrap around to zero, sum is a multiple of
+	 * MIN_BLOCKSIZE, so 32 bits are enough for both tests. */
+      } while (j < buffer_size &&
+	       likely((sum % MIN_BLOCKSIZE != MIN_BLOCKSIZE - 1) |
+		      (((sum + 1) & mask) != 0)));
+      fnv_store(self->fnv + lane, v);
+    }
+    else
+#endif
+    {
+      c = buffer[j];
+      h2 -= h1;
+      h2 += ROLLING_WINDOW * (uint32_t)c;
+      h1 += (uint32_t)c;
+      h1 -= (uint32_t)buffer[j - ROLLING_WINDOW];
+      h3 <<= 5;
+      h3 ^= c;
+      fnv_update(self->fnv, 2 * self->bhstart, 2 * self->bhend, c);
+      if (self->flags & FUZZY_STATE_NEED_LASTHASH)
+	self->lasth = sum_hash(c, self->lasth);
+      sum = h1 + h2 + h3;
+      ++j;
+    }
+
+    if (sum % MIN_BLOCKSIZE == MIN_BLOCKSIZE - 1)
+      fuzzy_engine_reset(self, (uint_least64_t)sum + 1);
+  }
+
+  roll_sync(&self->roll, h1, h2, h3, buffer, buffer_size, start);
+}
+
+static void fuzzy_count_input(struct fuzzy_state *self, size_t buffer_size)
+{
   if (self->total_size <= SSDEEP_TOTAL_SIZE_MAX) {
     if (buffer_size > SSDEEP_TOTAL_SIZE_MAX ||
 	SSDEEP_TOTAL_SIZE_MAX - buffer_size < self->total_size ) {
@@ -301,8 +569,213 @@ int fuzzy_update(struct fuzzy_state *self,
     else
       self->total_size += buffer_size;
   }
-  for ( ;buffer_size > 0; ++buffer, --buffer_size)
-    fuzzy_engine_step(self, *buffer);
+}
+
+int fuzzy_update(struct fuzzy_state *self,
+		 const unsigned char *buffer,
+		 size_t buffer_size) {
+  fuzzy_count_input(self, buffer_size);
+  fuzzy_engine_run(self, buffer, buffer_size);
+  return 0;
+}
+
+#if FNV_VECTOR > 1
+/* Bytes fed to a stream on its own before checking whether it can be
+ * paired again, see multi_lane_settle */
+#define MULTI_SLICE 4096
+
+/* A stream being fed by fuzzy_update_multi. While it is in a lane, its
+ * rolling hash is kept here, and the window is read from the buffer as
+ * in fuzzy_engine_run. The window was at position start when the buffer
+ * began. */
+struct multi_lane
+{
+  struct fuzzy_state *self;
+  const unsigned char *buffer, *p, *end;
+  size_t start;
+  uint32_t h1, h2, h3;
+};
+
+/* Whether the active hashes of a state fit in half a vector, so that two
+ * streams can share one. */
+static int multi_lane_pairable(const struct fuzzy_state *self)
+{
+  return 2 * (self->bhend - self->bhstart) <= FNV_VECTOR / 2 &&
+    !(self->flags & FUZZY_STATE_NEED_LASTHASH);
+}
+
+static uint32_t multi_lane_roll(struct multi_lane *l, unsigned char c)
+{
+  l->h2 -= l->h1;
+  l->h2 += ROLLING_WINDOW * (uint32_t)c;
+  l->h1 += (uint32_t)c;
+  l->h1 -= (uint32_t)l->p[-ROLLING_WINDOW];
+  l->h3 <<= 5;
+  l->h3 ^= c;
+  ++l->p;
+  return l->h1 + l->h2 + l->h3;
+}
+
+static void multi_lane_sync(struct multi_lane *l)
+{
+  roll_sync(&l->self->roll, l->h1, l->h2, l->h3,
+	    l->buffer, (size_t)(l->p - l->buffer), l->start);
+}
+
+/* Feed two streams side by side until one of them runs out of input or
+ * can't be paired any more. The FNV hashes of both are updated in one
+ * vector, and since the two rolling hashes don't depend on each other,
+ * the processor can work on one while the other waits. */
+static void multi_lane_run(struct multi_lane *lanes)
+{
+  struct multi_lane a = lanes[0], b = lanes[1];
+  struct fuzzy_state *sa = a.self, *sb = b.self;
+  uint32_t mask_a = ((uint32_t)1 << sa->bhstart) - 1;
+  uint32_t mask_b = ((uint32_t)1 << sb->bhstart) - 1;
+  uint32_t sum_a, sum_b;
+  unsigned char ca, cb;
+  int ta, tb;
+  size_t n = (size_t)(a.end - a.p);
+  fnv_vector v;
+
+  if ((size_t)(b.end - b.p) < n)
+    n = (size_t)(b.end - b.p);
+  v = fnv_pair(fnv_half_load(sa->fnv + 2 * sa->bhstart),
+	       fnv_half_load(sb->fnv + 2 * sb->bhstart));
+  while (n-- > 0)
+  {
+    ca = *a.p;
+    cb = *b.p;
+    sum_a = multi_lane_roll(&a, ca);
+    sum_b = multi_lane_roll(&b, cb);
+    v = fnv_mix(v, fnv_set2(ca, cb));
+    ta = (sum_a % MIN_BLOCKSIZE == MIN_BLOCKSIZE - 1) &
+      (((sum_a + 1) & mask_a) == 0);
+    tb = (sum_b % MIN_BLOCKSIZE == MIN_BLOCKSIZE - 1) &
+      (((sum_b + 1) & mask_b) == 0);
+    if (unlikely(ta | tb))
+    {
+      fnv_half_store(sa->fnv + 2 * sa->bhstart, v);
+      fnv_half_store_high(sb->fnv + 2 * sb->bhstart, v);
+      if (ta)
+	fuzzy_engine_reset(sa, (uint_least64_t)sum_a + 1);
+      if (tb)
+	fuzzy_engine_reset(sb, (uint_least64_t)sum_b + 1);
+      mask_a = ((uint32_t)1 << sa->bhstart) - 1;
+      mask_b = ((uint32_t)1 << sb->bhstart) - 1;
+      v = fnv_pair(fnv_half_load(sa->fnv + 2 * sa->bhstart),
+		   fnv_half_load(sb->fnv + 2 * sb->bhstart));
+      if (!multi_lane_pairable(sa) || !multi_lane_pairable(sb))
+	break;
+    }
+  }
+  fnv_half_store(sa->fnv + 2 * sa->bhstart, v);
+  fnv_half_store_high(sb->fnv + 2 * sb->bhstart, v);
+  lanes[0] = a;
+  lanes[1] = b;
+}
+
+/* Feed a stream on its own while it can't be paired. Returns zero, with
+ * the rolling hash handed back to the state, once it has run out of
+ * input. */
+static int multi_lane_settle(struct multi_lane *l)
+{
+  size_t slice;
+  while (l->p < l->end && !multi_lane_pairable(l->self))
+  {
+    slice = (size_t)(l->end - l->p);
+    if (slice > MULTI_SLICE)
+      slice = MULTI_SLICE;
+    multi_lane_sync(l);
+    fuzzy_engine_run(l->self, l->p, slice);
+    l->p += slice;
+    l->h1 = l->self->roll.h1;
+    l->h2 = l->self->roll.h2;
+    l->h3 = l->self->roll.h3;
+  }
+  if (l->p < l->end)
+    return 1;
+  multi_lane_sync(l);
+  return 0;
+}
+
+/* Put a stream into a lane. Until the window has been filled from the
+ * buffer the rolling hash needs the window of the state, so the first
+ * bytes are fed one at a time. Returns zero if the stream was finished
+ * without taking the lane. */
+static int multi_lane_load(struct multi_lane *l,
+			   struct fuzzy_state *self,
+			   const unsigned char *buffer,
+			   size_t size)
+{
+  size_t j;
+  l->start = self->roll.n;
+  for (j = 0; j < size && j < ROLLING_WINDOW; ++j)
+    fuzzy_engine_step(self, buffer[j]);
+  if (j == size)
+    return 0;
+  l->self = self;
+  l->buffer = buffer;
+  l->p = buffer + j;
+  l->end = buffer + size;
+  l->h1 = self->roll.h1;
+  l->h2 = self->roll.h2;
+  l->h3 = self->roll.h3;
+  return multi_lane_settle(l);
+}
+#endif
+
+int fuzzy_update_multi(struct fuzzy_state *const *states,
+		       const unsigned char *const *buffers,
+		       const size_t *buffer_sizes,
+		       size_t count)
+{
+  size_t i;
+#if FNV_VECTOR > 1
+  struct multi_lane lanes[2];
+  unsigned int active = 0, k;
+#endif
+
+  for (i = 0; i < count; ++i)
+    if (NULL == states[i] || (NULL == buffers[i] && buffer_sizes[i] > 0))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  for (i = 0; i < count; ++i)
+    fuzzy_count_input(states[i], buffer_sizes[i]);
+
+#if FNV_VECTOR > 1
+  i = 0;
+  for (;;)
+  {
+    while (active < 2 && i < count)
+    {
+      if (multi_lane_load(lanes + active, states[i], buffers[i],
+			  buffer_sizes[i]))
+	++active;
+      ++i;
+    }
+    if (active < 2)
+      break;
+    multi_lane_run(lanes);
+    for (k = 0; k < active; )
+      if (multi_lane_settle(lanes + k))
+	++k;
+      else
+	lanes[k] = lanes[--active];
+  }
+  /* The last stream is left without a partner */
+  if (active > 0)
+  {
+    multi_lane_sync(lanes);
+    fuzzy_engine_run(lanes[0].self, lanes[0].p,
+		     (size_t)(lanes[0].end - lanes[0].p));
+  }
+#else
+  for (i = 0; i < count; ++i)
+    fuzzy_engine_run(states[i], buffers[i], buffer_sizes[i]);
+#endif
   return 0;
 }
 
@@ -336,21 +809,22 @@ int fuzzy_digest(const struct fuzzy_state *self,
   unsigned int bi = self->bhstart;
   uint32_t h = roll_sum(&self->roll);
   int i, remain = FUZZY_MAX_RESULT - 1; /* Exclude terminating '\0'. */
-  /* Verify that our elimination was not overeager. */
-  assert(bi == 0 || (uint_least64_t)SSDEEP_BS(bi) / 2 * SPAMSUM_LENGTH <
-	 self->total_size);
 
   if (self->total_size > SSDEEP_TOTAL_SIZE_MAX) {
     /* The input exceeds data types. */
     errno = EOVERFLOW;
     return -1;
   }
-  /* Fixed size optimization. */
+  /* Fixed size optimization. The blocksizes were dropped for the size
+   * we were promised, so a file which shrank can't be checked below. */
   if ((self->flags & FUZZY_STATE_SIZE_FIXED) &&
       self->fixed_size != self->total_size) {
     errno = EINVAL;
     return -1;
   }
+  /* Verify that our elimination was not overeager. */
+  assert(bi == 0 || (uint_least64_t)SSDEEP_BS(bi) / 2 * SPAMSUM_LENGTH <
+	 self->total_size);
   /* Initial blocksize guess. */
   while ((uint_least64_t)SSDEEP_BS(bi) * SPAMSUM_LENGTH < self->total_size)
     ++bi;
@@ -359,7 +833,13 @@ int fuzzy_digest(const struct fuzzy_state *self,
     bi = self->bhend - 1;
   while (bi > self->bhstart && self->bh[bi].dindex < SPAMSUM_LENGTH / 2)
     --bi;
-  assert (!(bi > 0 && self->bh[bi].dindex < SPAMSUM_LENGTH / 2));
+  if (bi > 0 && self->bh[bi].dindex < SPAMSUM_LENGTH / 2)
+  {
+    /* The digest needs one of the blocksizes which were skipped */
+    assert(self->flags & FUZZY_STATE_SIZE_GUESSED);
+    errno = ERANGE;
+    return -1;
+  }
 
   i = snprintf(result, (size_t)remain, "%lu:", (unsigned long)SSDEEP_BS(bi));
   if (i <= 0)
@@ -379,7 +859,7 @@ int fuzzy_digest(const struct fuzzy_state *self,
   if (h != 0)
   {
     assert(remain > 0);
-    *result = b64[self->bh[bi].h % 64];
+    *result = b64[FNV_H(self, bi)];
     if((flags & FUZZY_FLAG_ELIMSEQ) == 0 || i < 3 ||
        *result != result[-1] ||
        *result != result[-2] ||
@@ -418,9 +898,9 @@ int fuzzy_digest(const struct fuzzy_state *self,
     remain -= i;
     if (h != 0) {
       assert(remain > 0);
-      h = (flags & FUZZY_FLAG_NOTRUNC) != 0 ? self->bh[bi].h :
-	self->bh[bi].halfh;
-      *result = b64[h % 64];
+      h = (flags & FUZZY_FLAG_NOTRUNC) != 0 ? FNV_H(self, bi) :
+	FNV_HALFH(self, bi);
+      *result = b64[h];
       if ((flags & FUZZY_FLAG_ELIMSEQ) == 0 || i < 3 ||
 	  *result != result[-1] ||
 	  *result != result[-2] ||
@@ -450,7 +930,7 @@ int fuzzy_digest(const struct fuzzy_state *self,
       assert(bi == 0 || bi == NUM_BLOCKHASHES - 1);
       assert(remain > 0);
       if (bi == 0)
-	*result++ = b64[self->bh[bi].h % 64];
+	*result++ = b64[FNV_H(self, bi)];
       else
 	*result++ = b64[self->lasth % 64];
       /* No need to bother with FUZZY_FLAG_ELIMSEQ, because this
@@ -466,24 +946,199 @@ void fuzzy_free(/*@only@*/ struct fuzzy_state *self)
   free(self);
 }
 
+/* An exported state starts with a header, all multi-byte values little
+ * endian:
+ *   0  magic "FzSt"
+ *   4  format version
+ *   5  NUM_BLOCKHASHES, which must match on import
+ *   6  bhstart, bhend, bhendlimit, flags, lasth, roll.n
+ *  12  total_size, fixed_size (8 bytes each)
+ *  28  roll.h1, roll.h2, roll.h3 (4 bytes each)
+ *  40  roll.window
+ * It is followed by each active blockhash, from bhstart up: its h and
+ * halfh hashes, halfdigest, dindex and the digest up to and including
+ * digest[dindex]. Nothing else in the state is ever read again. */
+#define STATE_EXPORT_VERSION 1
+#define STATE_EXPORT_HEADER (40 + ROLLING_WINDOW)
+#define STATE_EXPORT_FLAGS \
+  (FUZZY_STATE_NEED_LASTHASH | FUZZY_STATE_SIZE_FIXED | \
+   FUZZY_STATE_SIZE_GUESSED)
+
+typedef char state_export_fits[(STATE_EXPORT_HEADER + NUM_BLOCKHASHES *
+				(4 + SPAMSUM_LENGTH) <=
+				FUZZY_MAX_STATE_EXPORT) ? 1 : -1];
+
+static void put_le(unsigned char *p, uint_least64_t v, unsigned int n)
+{
+  unsigned int i;
+  for (i = 0; i < n; ++i, v >>= 8)
+    p[i] = (unsigned char)(v & 0xff);
+}
+
+static uint_least64_t get_le(const unsigned char *p, unsigned int n)
+{
+  uint_least64_t v = 0;
+  while (n-- > 0)
+    v = (v << 8) | p[n];
+  return v;
+}
+
+int fuzzy_state_export(const struct fuzzy_state *state,
+		       /*@out@*/ unsigned char *buffer,
+		       size_t buffer_size)
+{
+  unsigned char *p = buffer + STATE_EXPORT_HEADER;
+  const struct blockhash_context *bh;
+  size_t need = STATE_EXPORT_HEADER;
+  unsigned int i;
+  for (i = state->bhstart; i < state->bhend; ++i)
+    need += 4 + state->bh[i].dindex + 1;
+  if (buffer_size < need)
+  {
+    errno = ERANGE;
+    return -1;
+  }
+
+  memcpy(buffer, "FzSt", 4);
+  buffer[4] = STATE_EXPORT_VERSION;
+  buffer[5] = NUM_BLOCKHASHES;
+  buffer[6] = (unsigned char)state->bhstart;
+  buffer[7] = (unsigned char)state->bhend;
+  buffer[8] = (unsigned char)state->bhendlimit;
+  buffer[9] = (unsigned char)state->flags;
+  buffer[10] = (unsigned char)(state->lasth % 64);
+  buffer[11] = (unsigned char)state->roll.n;
+  put_le(buffer + 12, state->total_size, 8);
+  put_le(buffer + 20, (state->flags & FUZZY_STATE_SIZE_FIXED) ?
+	 state->fixed_size : 0, 8);
+  put_le(buffer + 28, state->roll.h1, 4);
+  put_le(buffer + 32, state->roll.h2, 4);
+  put_le(buffer + 36, state->roll.h3, 4);
+  memcpy(buffer + 40, state->roll.window, ROLLING_WINDOW);
+
+  for (i = state->bhstart; i < state->bhend; ++i)
+  {
+    bh = state->bh + i;
+    *p++ = FNV_H(state, i);
+    *p++ = FNV_HALFH(state, i);
+    *p++ = (unsigned char)bh->halfdigest;
+    *p++ = (unsigned char)bh->dindex;
+    memcpy(p, bh->digest, bh->dindex + 1);
+    p += bh->dindex + 1;
+  }
+  return (int)need;
+}
+
+/* Whether c is a signature character, or is '\0' and that is allowed */
+static int state_import_char(unsigned char c, int allow_end)
+{
+  if ('\0' == c)
+    return allow_end;
+  return NULL != strchr(b64, c);
+}
+
+/* Check the blockhashes of an exported state and return its length,
+ * or zero if it is malformed. */
+static size_t state_import_length(const unsigned char *buffer,
+				  size_t buffer_size)
+{
+  size_t off = STATE_EXPORT_HEADER;
+  unsigned int i, j, dindex;
+  for (i = buffer[6]; i < buffer[7]; ++i)
+  {
+    if (buffer_size - off < 4)
+      return 0;
+    dindex = buffer[off + 3];
+    if (buffer[off] >= 64 || buffer[off + 1] >= 64 ||
+	!state_import_char(buffer[off + 2], 1) ||
+	dindex >= SPAMSUM_LENGTH ||
+	buffer_size - off - 4 < dindex + 1)
+      return 0;
+    /* The last blockhash is forked as soon as it hits a reset point,
+     * unless it is already the last one allowed */
+    if (i == buffer[7] - 1u && dindex > 0 && buffer[7] <= buffer[8])
+      return 0;
+    off += 4;
+    for (j = 0; j <= dindex; ++j)
+      if (!state_import_char(buffer[off + j], j == dindex))
+	return 0;
+    off += dindex + 1;
+  }
+  return off;
+}
+
+int fuzzy_state_import(struct fuzzy_state *state,
+		       const unsigned char *buffer,
+		       size_t buffer_size)
+{
+  const unsigned char *p = buffer + STATE_EXPORT_HEADER;
+  struct blockhash_context *bh;
+  uint_least64_t size;
+  unsigned int i;
+
+  if (buffer_size < STATE_EXPORT_HEADER ||
+      memcmp(buffer, "FzSt", 4) != 0 ||
+      buffer[4] != STATE_EXPORT_VERSION ||
+      buffer[5] != NUM_BLOCKHASHES ||
+      buffer[6] >= buffer[7] ||
+      buffer[7] > NUM_BLOCKHASHES ||
+      buffer[8] >= NUM_BLOCKHASHES ||
+      (buffer[9] & ~STATE_EXPORT_FLAGS) != 0 ||
+      buffer[10] >= 64 ||
+      buffer[11] >= ROLLING_WINDOW ||
+      get_le(buffer + 12, 8) > SSDEEP_TOTAL_SIZE_MAX + 1 ||
+      get_le(buffer + 20, 8) > SSDEEP_TOTAL_SIZE_MAX ||
+      state_import_length(buffer, buffer_size) != buffer_size)
+    goto invalid;
+  /* Blockhashes are only dropped once the input is too large for them */
+  size = get_le(buffer + ((buffer[9] & FUZZY_STATE_SIZE_FIXED) ? 20 : 12), 8);
+  if (buffer[6] > 0 &&
+      (uint_least64_t)SSDEEP_BS(buffer[6] - 1) * SPAMSUM_LENGTH >= size)
+    goto invalid;
+
+  (void)fuzzy_init(state);
+  state->bhstart = buffer[6];
+  state->bhend = buffer[7];
+  state->bhendlimit = buffer[8];
+  state->flags = buffer[9];
+  state->lasth = buffer[10];
+  state->roll.n = buffer[11];
+  state->total_size = get_le(buffer + 12, 8);
+  state->fixed_size = get_le(buffer + 20, 8);
+  state->roll.h1 = (uint32_t)get_le(buffer + 28, 4);
+  state->roll.h2 = (uint32_t)get_le(buffer + 32, 4);
+  state->roll.h3 = (uint32_t)get_le(buffer + 36, 4);
+  memcpy(state->roll.window, buffer + 40, ROLLING_WINDOW);
+
+  for (i = state->bhstart; i < state->bhend; ++i)
+  {
+    bh = state->bh + i;
+    FNV_H(state, i) = *p++;
+    FNV_HALFH(state, i) = *p++;
+    bh->halfdigest = (char)*p++;
+    bh->dindex = *p++;
+    memcpy(bh->digest, p, bh->dindex + 1);
+    p += bh->dindex + 1;
+  }
+  return 0;
+
+ invalid:
+  errno = EINVAL;
+  return -1;
+}
+
 int fuzzy_hash_buf(const unsigned char *buf,
 		   uint32_t buf_len,
 		   /*@out@*/ char *result)
 {
-  struct fuzzy_state *ctx;
-  int ret = -1;
-  if (NULL == (ctx = fuzzy_new()))
-    return -1;
+  struct fuzzy_state state, *ctx = fuzzy_init(&state);
   if (fuzzy_set_total_input_length(ctx, buf_len) < 0)
-    goto out;
+    return -1;
   if (fuzzy_update(ctx, buf, buf_len) < 0)
-    goto out;
+    return -1;
   if (fuzzy_digest(ctx, result, 0) < 0)
-    goto out;
-  ret = 0;
- out:
-  fuzzy_free(ctx);
-  return ret;
+    return -1;
+  return 0;
 }
 
 static int fuzzy_update_stream(struct fuzzy_state *state,
@@ -506,18 +1161,12 @@ static int fuzzy_update_stream(struct fuzzy_state *state,
 
 int fuzzy_hash_stream(FILE *handle, /*@out@*/ char *result)
 {
-  struct fuzzy_state *ctx;
-  int ret = -1;
-  if (NULL == (ctx = fuzzy_new()))
-    return -1;
+  struct fuzzy_state state, *ctx = fuzzy_init(&state);
   if (fuzzy_update_stream(ctx, handle) < 0)
-    goto out;
+    return -1;
   if (fuzzy_digest(ctx, result, 0) < 0)
-    goto out;
-  ret = 0;
- out:
-  fuzzy_free(ctx);
-  return ret;
+    return -1;
+  return 0;
 }
 
 #ifdef S_SPLINT_S
@@ -529,8 +1178,8 @@ off_t ftello(FILE *);
 int fuzzy_hash_file(FILE *handle, /*@out@*/ char *result)
 {
   off_t fpos, fposend;
-  int status = -1;
-  struct fuzzy_state *ctx;
+  int status;
+  struct fuzzy_state state, *ctx = fuzzy_init(&state);
   fpos = ftello(handle);
   if (fpos < 0)
     return -1;
@@ -541,167 +1190,698 @@ int fuzzy_hash_file(FILE *handle, /*@out@*/ char *result)
     return -1;
   if (fseeko(handle, 0, SEEK_SET) < 0)
     return -1;
-  if (NULL == (ctx = fuzzy_new()))
-    return -1;
   if (fuzzy_set_total_input_length(ctx, (uint_least64_t)fposend) < 0)
-    goto out;
+    return -1;
   if (fuzzy_update_stream(ctx, handle) < 0)
-    goto out;
+    return -1;
   status = fuzzy_digest(ctx, result, 0);
-out:
   if (status == 0)
   {
     if (fseeko(handle, fpos, SEEK_SET) < 0)
       return -1;
   }
-  fuzzy_free(ctx);
   return status;
 }
 
-int fuzzy_hash_filename(const char *filename, /*@out@*/ char *result)
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PREAD) && FNV_VECTOR > 1
+/* A large input can be hashed in segments on several threads at once.
+ * The rolling hash only depends on the last ROLLING_WINDOW bytes, so each
+ * segment can find its own reset points. The FNV hashes can't be carried
+ * over from the previous segment, because it hasn't been hashed yet, but
+ * with only 64 possible values they can be hashed from all of them at
+ * once. Each segment tracks where every value would have been taken by
+ * the input so far. Joining these maps gives the FNV hash between any
+ * two reset points, which is all a blockhash needs. */
+
+/* Smallest segment worth handing to a thread of its own */
+#define SEGMENT_MIN_SIZE (UINT64_C(16) << 20)
+#define SEGMENT_READ_SIZE (1 << 20)
+/* Reset points are only kept for blocksizes this far below the one
+ * the input size suggests, and the digest is very unlikely to need a
+ * smaller one. */
+#define SEGMENT_LEVELS_BELOW 4
+/* A segment keeping more reset points than this gives up */
+#define SEGMENT_MAX_TRIGGERS 65536
+#define FNV_MAP_VECTORS (64 / FNV_VECTOR)
+
+/* The value each of the 64 FNV values would have after some input */
+typedef unsigned char fnv_map[64];
+
+struct segment_trigger
 {
-  int status;
-  FILE *handle = fopen(filename, "rb");
-  if (NULL == handle)
-    return -1;
-  status = fuzzy_hash_stream(handle, result);
-  /* We cannot do anything about an fclose failure. */
-  (void)fclose(handle);
-  return status;
-}
+  /* The largest blockhash index with a reset point here */
+  unsigned int level;
+  /* The FNV map from the start of the segment up to here */
+  fnv_map map;
+};
 
-//
-// We only accept a match if we have at least one common substring in
-// the signature of length ROLLING_WINDOW. This dramatically drops the
-// false positive rate for low score thresholds while having
-// negligable affect on the rate of spam detection.
-//
-// return 1 if the two strings do have a common substring, 0 otherwise
-//
-static int has_common_substring(const char *s1, const char *s2)
+struct segment_job
 {
-  int i, j;
-  int num_hashes;
-  uint32_t hashes[SPAMSUM_LENGTH];
-
-  // there are many possible algorithms for common substring
-  // detection. In this case I am re-using the rolling hash code
-  // to act as a filter for possible substring matches
-
-  memset(hashes, 0, sizeof(hashes));
-
-  // first compute the windowed rolling hash at each offset in
-  // the first string
-  struct roll_state state;
-  roll_init (&state);
+  int fd;
+  uint_least64_t start, end;
+  unsigned int min_level;
+  /* An errno value, or zero */
+  int error;
+  /* Set if there were too many reset points to keep */
+  int overflow;
+  /* Set if there was a reset point for any blocksize at all */
+  int resets;
+  struct segment_trigger *triggers;
+  size_t count, size;
+  /* The FNV map for the whole segment */
+  fnv_map map;
+  /* The last bytes of the segment */
+  unsigned char tail[ROLLING_WINDOW];
+};
 
-  for (i=0;s1[i];i++)
+static int segment_read(int fd,
+			unsigned char *buffer,
+			size_t size,
+			uint_least64_t offset)
+{
+  ssize_t n;
+  while (size > 0)
   {
-    roll_hash(&state, (unsigned char)s1[i]);
-    hashes[i] = roll_sum(&state);
+    n = pread(fd, buffer, size, (off_t)offset);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      return -1;
+    if (n == 0)
+    {
+      /* The file has been truncated */
+      errno = EINVAL;
+      return -1;
+    }
+    buffer += n;
+    size -= (size_t)n;
+    offset += (uint_least64_t)n;
   }
-  num_hashes = i;
+  return 0;
+}
 
-  roll_init(&state);
+static int segment_add_trigger(struct segment_job *job,
+			       unsigned int level,
+			       const fnv_map map)
+{
+  struct segment_trigger *t;
+  if (job->count == job->size)
+  {
+    if (job->size == SEGMENT_MAX_TRIGGERS)
+    {
+      job->overflow = 1;
+      return -1;
+    }
+    job->size = job->size ? 2 * job->size : 256;
+    t = realloc(job->triggers, job->size * sizeof(struct segment_trigger));
+    if (NULL == t)
+      return -1;
+    job->triggers = t;
+  }
+  t = job->triggers + job->count++;
+  t->level = level;
+  memcpy(t->map, map, sizeof(fnv_map));
+  return 0;
+}
 
-  // now for each offset in the second string compute the
-  // rolling hash and compare it to all of the rolling hashes
-  // for the first string. If one matches then we have a
-  // candidate substring match. We then confirm that match with
-  // a direct string comparison */
-  for (i=0;s2[i];i++)
+static void *segment_hash(void *arg)
+{
+  struct segment_job *job = (struct segment_job *)arg;
+  unsigned char *buffer;
+  uint_least64_t pos = job->start;
+  uint32_t h1, h2, h3, sum, mask = ((uint32_t)1 << job->min_level) - 1;
+  unsigned int k, level, reset, resets = 0;
+  size_t j, n;
+  fnv_vector m0, m1, cv;
+#if FNV_MAP_VECTORS > 2
+  fnv_vector m2, m3;
+#endif
+  struct roll_state roll;
+
+  job->error = 0;
+  if (NULL == (buffer = malloc(ROLLING_WINDOW + SEGMENT_READ_SIZE)))
+  {
+    job->error = errno;
+    return NULL;
+  }
+  /* The bytes before the segment fill the rolling window. Before the
+   * start of the input, the window holds zeros. */
+  memset(buffer, 0, ROLLING_WINDOW);
+  if (pos > 0 && segment_read(job->fd, buffer, ROLLING_WINDOW,
+			      pos - ROLLING_WINDOW) < 0)
+    goto out;
+  roll_init(&roll);
+  for (j = 0; j < ROLLING_WINDOW; ++j)
+    roll_hash(&roll, buffer[j]);
+  h1 = roll.h1;
+  h2 = roll.h2;
+  h3 = roll.h3;
+
+  /* The map is kept in registers, a vector for each FNV_VECTOR values */
+  for (k = 0; k < 64; ++k)
+    job->map[k] = (unsigned char)k;
+  m0 = fnv_load(job->map);
+  m1 = fnv_load(job->map + FNV_VECTOR);
+#if FNV_MAP_VECTORS > 2
+  m2 = fnv_load(job->map + 2 * FNV_VECTOR);
+  m3 = fnv_load(job->map + 3 * FNV_VECTOR);
+#endif
+
+  while (pos < job->end)
   {
-    roll_hash(&state, (unsigned char)s2[i]);
-    uint32_t h = roll_sum(&state);
-    if (i < ROLLING_WINDOW-1) continue;
-    for (j=ROLLING_WINDOW-1;j<num_hashes;j++)
+    n = SEGMENT_READ_SIZE;
+    if (job->end - pos < n)
+      n = (size_t)(job->end - pos);
+    if (segment_read(job->fd, buffer + ROLLING_WINDOW, n, pos) < 0)
+      goto out;
+    for (j = ROLLING_WINDOW; j < ROLLING_WINDOW + n; ++j)
     {
-      if (hashes[j] == h)
-      {
-	// we have a potential match - confirm it
-	if (strlen(s2+i-(ROLLING_WINDOW-1)) >= ROLLING_WINDOW &&
-	    strncmp(s2+i-(ROLLING_WINDOW-1),
-		    s1+j-(ROLLING_WINDOW-1),
-		    ROLLING_WINDOW) == 0)
-	{
-	  return 1;
-	}
+      h2 -= h1;
+      h2 += ROLLING_WINDOW * (uint32_t)buffer[j];
+      h1 += (uint32_t)buffer[j];
+      h1 -= (uint32_t)buffer[j - ROLLING_WINDOW];
+      h3 <<= 5;
+      h3 ^= buffer[j];
+      cv = fnv_set1(buffer[j]);
+      m0 = fnv_mix(m0, cv);
+      m1 = fnv_mix(m1, cv);
+#if FNV_MAP_VECTORS > 2
+      m2 = fnv_mix(m2, cv);
+      m3 = fnv_mix(m3, cv);
+#endif
+      sum = h1 + h2 + h3;
+      reset = (sum % MIN_BLOCKSIZE == MIN_BLOCKSIZE - 1);
+      resets |= reset;
+      if (likely(!reset | (((sum + 1) & mask) != 0)))
+	continue;
+      for (level = job->min_level;
+	   level < NUM_BLOCKHASHES - 1 &&
+	     ((sum + 1) & ((uint32_t)1 << level)) == 0;
+	   ++level)
+	;
+      fnv_store(job->map, m0);
+      fnv_store(job->map + FNV_VECTOR, m1);
+#if FNV_MAP_VECTORS > 2
+      fnv_store(job->map + 2 * FNV_VECTOR, m2);
+      fnv_store(job->map + 3 * FNV_VECTOR, m3);
+#endif
+      if (segment_add_trigger(job, level, job->map) < 0)
+	goto out;
+    }
+    memmove(buffer, buffer + n, ROLLING_WINDOW);
+    pos += n;
+  }
+
+  fnv_store(job->map, m0);
+  fnv_store(job->map + FNV_VECTOR, m1);
+#if FNV_MAP_VECTORS > 2
+  fnv_store(job->map + 2 * FNV_VECTOR, m2);
+  fnv_store(job->map + 3 * FNV_VECTOR, m3);
+#endif
+  memcpy(job->tail, buffer, ROLLING_WINDOW);
+  job->resets = (int)resets;
+  free(buffer);
+  return NULL;
+
+ out:
+  if (!job->overflow)
+    job->error = errno;
+  free(buffer);
+  return NULL;
+}
+
+/* Fill in blockhash i of self as if all of the input had been fed to
+ * it, given the FNV map from the start of the input to each of the
+ * reset points and to its end. An FNV hash started at some reset point
+ * is kept as the value which the map up to that point takes to
+ * HASH_INIT6. */
+static void segment_blockhash(struct fuzzy_state *self,
+			      unsigned int i,
+			      const struct segment_trigger *triggers,
+			      size_t count,
+			      const unsigned char *end)
+{
+  struct blockhash_context *bh = self->bh + i;
+  unsigned char h = HASH_INIT6, halfh = HASH_INIT6;
+  const unsigned char *map;
+  size_t t;
+
+  bh->digest[0] = '\0';
+  bh->halfdigest = '\0';
+  bh->dindex = 0;
+  for (t = 0; t < count; ++t)
+  {
+    if (triggers[t].level < i)
+      continue;
+    map = triggers[t].map;
+    bh->digest[bh->dindex] = b64[map[h]];
+    bh->halfdigest = b64[map[halfh]];
+    if (bh->dindex < SPAMSUM_LENGTH - 1) {
+      bh->digest[++(bh->dindex)] = '\0';
+      for (h = 0; map[h] != HASH_INIT6; ++h)
+	;
+      if (bh->dindex < SPAMSUM_LENGTH / 2) {
+	halfh = h;
+	bh->halfdigest = '\0';
       }
     }
   }
+  FNV_H(self, i) = end[h];
+  FNV_HALFH(self, i) = end[halfh];
+}
 
-  return 0;
+/* Join the segments into the state a single fuzzy_state would have
+ * reached and take its digest. Returns 1 if the digest would need a
+ * blocksize for which the reset points weren't kept. */
+static int segment_digest(const struct segment_job *jobs,
+			  unsigned int segments,
+			  uint_least64_t size,
+			  /*@out@*/ char *result)
+{
+  struct fuzzy_state *self;
+  struct segment_trigger *triggers = NULL;
+  fnv_map end, map;
+  size_t count = 0, t, n, j;
+  unsigned int k, i, bi, top = 0, min_level = jobs[0].min_level;
+  int status = -1;
+
+  if (NULL == (self = fuzzy_new()))
+    return -1;
+  if (fuzzy_set_total_input_length(self, size) < 0)
+    goto out;
+  self->total_size = size;
+
+  for (k = 0; k < segments; ++k)
+    count += jobs[k].count;
+  if (count > 0 &&
+      NULL == (triggers = malloc(count * sizeof(struct segment_trigger))))
+    goto out;
+
+  /* Chain the maps of the segments together */
+  for (j = 0; j < 64; ++j)
+    end[j] = (unsigned char)j;
+  for (k = 0, t = 0; k < segments; ++k)
+  {
+    for (n = 0; n < jobs[k].count; ++n, ++t)
+    {
+      triggers[t].level = jobs[k].triggers[n].level;
+      for (j = 0; j < 64; ++j)
+	triggers[t].map[j] = jobs[k].triggers[n].map[end[j]];
+      if (triggers[t].level > top)
+	top = triggers[t].level;
+    }
+    for (j = 0; j < 64; ++j)
+      map[j] = jobs[k].map[end[j]];
+    memcpy(end, map, sizeof(fnv_map));
+  }
+
+  if (0 == count)
+  {
+    /* Without any reset points at all, there's only the first
+     * blockhash, which is easy. Otherwise one of the ones which
+     * weren't kept might be needed. */
+    for (k = 0; k < segments; ++k)
+      if (jobs[k].resets && min_level > 0)
+      {
+	status = 1;
+	goto out;
+      }
+    min_level = 0;
+  }
+  /* Each blockhash is started at the first reset point of the one
+   * before it, up to bhendlimit. */
+  self->bhend = (0 == count) ? 1 :
+    ((top + 1 < self->bhendlimit) ? top + 1 : self->bhendlimit) + 1;
+  self->bhstart = min_level;
+  for (i = self->bhstart; i < self->bhend; ++i)
+    segment_blockhash(self, i, triggers, count, end);
+  if (self->bhend == NUM_BLOCKHASHES && top == NUM_BLOCKHASHES - 1)
+  {
+    self->flags |= FUZZY_STATE_NEED_LASTHASH;
+    self->lasth = end[HASH_INIT6];
+  }
+  for (j = 0; j < ROLLING_WINDOW; ++j)
+    roll_hash(&self->roll, jobs[segments - 1].tail[j]);
+
+  /* Make sure fuzzy_digest won't look below bhstart */
+  bi = self->bhstart;
+  while ((uint_least64_t)SSDEEP_BS(bi) * SPAMSUM_LENGTH < size)
+    ++bi;
+  if (bi >= self->bhend)
+    bi = self->bhend - 1;
+  while (bi > self->bhstart && self->bh[bi].dindex < SPAMSUM_LENGTH / 2)
+    --bi;
+  if (bi > 0 && self->bh[bi].dindex < SPAMSUM_LENGTH / 2)
+  {
+    status = 1;
+    goto out;
+  }
+
+  status = fuzzy_digest(self, result, 0);
+ out:
+  free(triggers);
+  fuzzy_free(self);
+  return status;
 }
 
+/* Hash the file in segments on separate threads. Returns 1 if it has to
+ * be hashed in one piece after all. */
+static int fuzzy_hash_segments(int fd,
+			       uint_least64_t size,
+			       unsigned int segments,
+			       /*@out@*/ char *result)
+{
+  struct segment_job *jobs;
+  pthread_t *threads;
+  unsigned int k, started, min_level = 0;
+  int status = -1;
+
+  while ((uint_least64_t)SSDEEP_BS(min_level) * SPAMSUM_LENGTH < size)
+    ++min_level;
+  min_level = (min_level > SEGMENT_LEVELS_BELOW) ?
+    min_level - SEGMENT_LEVELS_BELOW : 0;
+
+  jobs = calloc(segments, sizeof(struct segment_job));
+  threads = malloc(segments * sizeof(pthread_t));
+  if (NULL == jobs || NULL == threads)
+    goto out;
+  for (k = 0; k < segments; ++k)
+  {
+    jobs[k].fd = fd;
+    jobs[k].start = size / segments * k;
+    jobs[k].end = (k == segments - 1) ? size : size / segments * (k + 1);
+    jobs[k].min_level = min_level;
+  }
+
+  /* The calling thread hashes the first segment */
+  for (started = 1; started < segments; ++started)
+    if (pthread_create(threads + started, NULL, segment_hash, jobs + started))
+      break;
+  segment_hash(jobs);
+  for (k = 1; k < started; ++k)
+    pthread_join(threads[k], NULL);
+  for (k = started; k < segments; ++k)
+    segment_hash(jobs + k);
+
+  for (k = 0; k < segments; ++k)
+  {
+    if (jobs[k].overflow)
+    {
+      status = 1;
+      goto out;
+    }
+    if (jobs[k].error)
+    {
+      errno = jobs[k].error;
+      goto out;
+    }
+  }
+  status = segment_digest(jobs, segments, size, result);
+
+ out:
+  if (NULL != jobs)
+    for (k = 0; k < segments; ++k)
+      free(jobs[k].triggers);
+  free(jobs);
+  free(threads);
+  return status;
+}
 
-// eliminate sequences of longer than 3 identical characters. These
-// sequences contain very little information so they tend to just bias
-// the result unfairly
-static char *eliminate_sequences(const char *str)
+/* Number of segments an input of this size is split into */
+static unsigned int segment_count(uint_least64_t size, unsigned int threads)
 {
-  char *ret;
-  size_t i, j, len;
+  unsigned int segments = threads;
+  while (segments > 1 && size / segments < SEGMENT_MIN_SIZE)
+    --segments;
+  if (size > SSDEEP_TOTAL_SIZE_MAX)
+    return 1;
+  return segments;
+}
+#endif
 
-  ret = strdup(str);
-  if (!ret)
-    return NULL;
+int fuzzy_hash_file_parallel(FILE *handle,
+			     unsigned int threads,
+			     /*@out@*/ char *result)
+{
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PREAD) && FNV_VECTOR > 1
+  off_t fpos, fposend;
+  unsigned int segments;
+  int status;
+  fpos = ftello(handle);
+  if (fpos < 0)
+    return -1;
+  if (fseeko(handle, 0, SEEK_END) < 0)
+    return -1;
+  fposend = ftello(handle);
+  if (fposend < 0)
+    return -1;
+  if (fseeko(handle, fpos, SEEK_SET) < 0)
+    return -1;
+  segments = segment_count((uint_least64_t)fposend, threads);
+  if (segments > 1)
+  {
+    status = fuzzy_hash_segments(fileno(handle), (uint_least64_t)fposend,
+				 segments, result);
+    if (status <= 0)
+      return status;
+  }
+#else
+  (void)threads;
+#endif
+  return fuzzy_hash_file(handle, result);
+}
 
-  len = strlen(str);
-  if (len < 3)
-    return ret;
+/* Large enough that reading a file takes few system calls, and small
+ * enough to keep on the stack, so no file needs a heap allocation */
+#define FD_READ_SIZE (64 * 1024)
 
-  for (i=j=3 ; i<len ; i++)
+static int fuzzy_update_fd(struct fuzzy_state *state, int fd)
+{
+  unsigned char buffer[FD_READ_SIZE];
+  ssize_t n;
+  for (;;)
   {
-    if (str[i] != str[i-1] ||
-	str[i] != str[i-2] ||
-	str[i] != str[i-3])
+    n = read(fd, buffer, FD_READ_SIZE);
+    if (n < 0)
     {
-      ret[j++] = str[i];
+      if (EINTR == errno)
+	continue;
+      return -1;
     }
+    if (0 == n)
+      return 0;
+    if (fuzzy_update(state, buffer, (size_t)n) < 0)
+      return -1;
+  }
+}
+
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+/* Returns 1 if the file can't be mapped and has to be read instead */
+static int fuzzy_update_mapped(struct fuzzy_state *state, int fd,
+			       uint_least64_t size)
+{
+  void *map;
+  int status;
+  if (0 == size || size > SIZE_MAX)
+    return 1;
+  /* Pages past the end of a file which is truncated while it is being
+   * hashed can't be read, and touching them raises SIGBUS rather than
+   * returning an error. That is why callers have to ask for this with
+   * FUZZY_FLAG_MMAP. */
+  map = mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (MAP_FAILED == map)
+    return 1;
+#ifdef HAVE_MADVISE
+  (void)madvise(map, (size_t)size, MADV_SEQUENTIAL);
+#endif
+  status = fuzzy_update(state, (const unsigned char *)map, (size_t)size);
+  (void)munmap(map, (size_t)size);
+  return status;
+}
+#endif
+
+/* Hash a whole regular file once, tracking only the blocksizes the
+ * size suggests if guess is set. */
+static int fuzzy_hash_fd_pass(int fd, uint_least64_t size, int guess,
+			      /*@out@*/ char *result, unsigned int flags)
+{
+  struct fuzzy_state state, *ctx = fuzzy_init(&state);
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+  int status;
+#endif
+  if (fuzzy_set_total_input_length(ctx, size) < 0)
+    return -1;
+  if (guess && fuzzy_guess_blocksize(ctx) < 0)
+    return -1;
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+  status = ((flags & FUZZY_FLAG_MMAP) != 0) ?
+    fuzzy_update_mapped(ctx, fd, size) : 1;
+  if (status < 0)
+    return -1;
+  if (status > 0)
+#else
+  (void)flags;
+#endif
+  {
+    if (fuzzy_update_fd(ctx, fd) < 0)
+      return -1;
   }
+  return fuzzy_digest(ctx, result, 0);
+}
 
-  ret[j] = 0;
+int fuzzy_hash_fd(int fd, uint_least64_t size, unsigned int threads,
+		  /*@out@*/ char *result, unsigned int flags)
+{
+  int status;
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_PREAD) && FNV_VECTOR > 1
+  unsigned int segments = segment_count(size, threads);
+  if (segments > 1)
+  {
+    status = fuzzy_hash_segments(fd, size, segments, result);
+    if (status <= 0)
+      return status;
+  }
+#else
+  (void)threads;
+#endif
+  /* The file can be read again, so the smaller blocksizes are only
+   * hashed if the digest turns out to need them. */
+  status = fuzzy_hash_fd_pass(fd, size, 1, result, flags);
+  if (status < 0 && ERANGE == errno)
+  {
+    if (lseek(fd, 0, SEEK_SET) < 0)
+      return -1;
+    status = fuzzy_hash_fd_pass(fd, size, 0, result, flags);
+  }
+  return status;
+}
 
-  return ret;
+int fuzzy_hash_filename(const char *filename, /*@out@*/ char *result)
+{
+  int status;
+  FILE *handle = fopen(filename, "rb");
+  if (NULL == handle)
+    return -1;
+  status = fuzzy_hash_stream(handle, result);
+  /* We cannot do anything about an fclose failure. */
+  (void)fclose(handle);
+  return status;
 }
 
+// Open addressing set of the ROLLING_WINDOW length substrings of one
+// signature part. It has room for all SPAMSUM_LENGTH of them while
+// staying at most half full.
+#define GRAM_TABLE_SIZE 128
+#define GRAM_MASK  ((UINT64_C(1) << (8 * ROLLING_WINDOW)) - 1)
+#define GRAM_EMPTY UINT64_MAX
+#define GRAM_HASH(gram) ((gram) * UINT64_C(0x9e3779b97f4a7c15))
+#define GRAM_SLOT(gram) ((size_t)(GRAM_HASH(gram) >> 57))
+// Which of the FUZZY_SKETCH_WORDS * 64 sketch bits a window sets
+#define GRAM_SKETCH_BIT(gram) ((unsigned int)(GRAM_HASH(gram) >> 56))
+
 //
-// this is the low level string scoring algorithm. It takes two strings
-// and scores them on a scale of 0-100 where 0 is a terrible match and
-// 100 is a great match. The block_size is used to cope with very small
-// messages.
+// We only accept a match if we have at least one common substring in
+// the signature of length ROLLING_WINDOW. This dramatically drops the
+// false positive rate for low score thresholds while having
+// negligable affect on the rate of spam detection.
 //
-static uint32_t score_strings(const char *s1,
-			      const char *s2,
-			      unsigned long block_size)
+// return 1 if the two strings do have a common substring, 0 otherwise
+//
+static int has_common_substring(const char *s1,
+				size_t len1,
+				const char *s2,
+				size_t len2)
 {
-  uint32_t score;
-  size_t len1, len2;
-
-  len1 = strlen(s1);
-  len2 = strlen(s2);
+  uint64_t table[GRAM_TABLE_SIZE];
+  uint64_t gram;
+  size_t i, slot;
 
-  if (len1 > SPAMSUM_LENGTH || len2 > SPAMSUM_LENGTH) {
-    // not a real spamsum signature?
+  if (len1 < ROLLING_WINDOW || len2 < ROLLING_WINDOW)
     return 0;
+
+  // A window of ROLLING_WINDOW characters fits in a 64-bit word, so two
+  // windows are equal exactly when their packed values are. Put all of
+  // the windows of s1 into a small hash set and look up each window of
+  // s2 in it. This is linear in the lengths, where checking every window
+  // of s2 against every window of s1 was quadratic.
+  memset(table, 0xff, sizeof(table));
+
+  gram = 0;
+  for (i = 0; i < len1; i++)
+  {
+    gram = ((gram << 8) | (unsigned char)s1[i]) & GRAM_MASK;
+    if (i < ROLLING_WINDOW - 1)
+      continue;
+    slot = GRAM_SLOT(gram);
+    while (table[slot] != GRAM_EMPTY && table[slot] != gram)
+      slot = (slot + 1) & (GRAM_TABLE_SIZE - 1);
+    table[slot] = gram;
   }
 
-  // the two strings must have a common substring of length
-  // ROLLING_WINDOW to be candidates
-  if (has_common_substring(s1, s2) == 0) {
-    return 0;
+  gram = 0;
+  for (i = 0; i < len2; i++)
+  {
+    gram = ((gram << 8) | (unsigned char)s2[i]) & GRAM_MASK;
+    if (i < ROLLING_WINDOW - 1)
+      continue;
+    slot = GRAM_SLOT(gram);
+    while (table[slot] != GRAM_EMPTY)
+    {
+      if (table[slot] == gram)
+	return 1;
+      slot = (slot + 1) & (GRAM_TABLE_SIZE - 1);
+    }
   }
 
-  // compute the edit distance between the two strings. The edit distance gives
-  // us a pretty good idea of how closely related the two strings are
-  score = edit_distn(s1, len1, s2, len2);
+  return 0;
+}
+
+
+// Set the sketch bit for every ROLLING_WINDOW length substring of s
+static void compute_sketch(/*@out@*/ uint64_t *sketch, const char *s, size_t len)
+{
+  uint64_t gram = 0;
+  unsigned int bit;
+  size_t i;
+
+  memset(sketch, 0, FUZZY_SKETCH_WORDS * sizeof(uint64_t));
+  for (i = 0; i < len; i++)
+  {
+    gram = ((gram << 8) | (unsigned char)s[i]) & GRAM_MASK;
+    if (i < ROLLING_WINDOW - 1)
+      continue;
+    bit = GRAM_SKETCH_BIT(gram);
+    sketch[bit / 64] |= UINT64_C(1) << (bit % 64);
+  }
+}
+
+// Two parts can only have a common substring if their sketches share a
+// bit. This is a handful of word operations, which the compiler can
+// turn into a single vector AND, so it's much cheaper than
+// has_common_substring() for the many pairs which don't.
+static int sketches_intersect(const uint64_t *sketch1, const uint64_t *sketch2)
+{
+  uint64_t common = 0;
+  unsigned int i;
+
+  for (i = 0; i < FUZZY_SKETCH_WORDS; i++)
+    common |= sketch1[i] & sketch2[i];
+  return common != 0;
+}
+
+
+// Turn an edit distance between two strings whose lengths add up to
+// len_sum into a score on a 0-100 scale, ignoring the small blocksize cap.
+static uint32_t score_distance(uint32_t dist, size_t len_sum)
+{
+  uint32_t score;
 
   // scale the edit distance by the lengths of the two
   // strings. This changes the score to be a measure of the
   // proportion of the message that has changed rather than an
   // absolute quantity. It also copes with the variability of
   // the string lengths.
-  score = (score * SPAMSUM_LENGTH) / (len1 + len2);
+  score = (dist * SPAMSUM_LENGTH) / len_sum;
 
   // at this stage the score occurs roughly on a 0-SPAMSUM_LENGTH scale,
   // with 0 being a good match and SPAMSUM_LENGTH being a complete
@@ -712,117 +1892,264 @@ static uint32_t score_strings(const char *s1,
 
   // now re-scale on a 0-100 scale with 0 being a poor match and
   // 100 being a excellent match.
-  score = 100 - score;
+  return 100 - score;
+}
 
-  //  printf ("len1: %"PRIu32"  len2: %"PRIu32"\n", len1, len2);
+// The largest edit distance which still scores at least min_score, or
+// -1 if no distance does. The score only goes down as the distance goes
+// up, so we can search for it.
+static int max_distance(uint32_t min_score, size_t len_sum)
+{
+  int lo = 0, hi = (int)len_sum;
 
-  // when the blocksize is small we don't want to exaggerate the match size
-  if (block_size >= (99 + ROLLING_WINDOW) / ROLLING_WINDOW * MIN_BLOCKSIZE)
-    return score;
-  if (score > block_size/MIN_BLOCKSIZE * MIN(len1, len2))
+  if (score_distance(0, len_sum) < min_score)
+    return -1;
+  while (lo < hi)
   {
-    score = block_size/MIN_BLOCKSIZE * MIN(len1, len2);
+    int mid = (lo + hi + 1) / 2;
+    if (score_distance(mid, len_sum) >= min_score)
+      lo = mid;
+    else
+      hi = mid - 1;
   }
-  return score;
+  return lo;
 }
 
 //
-// Given two spamsum strings return a value indicating the degree
-// to which they match.
+// this is the low level string scoring algorithm. It takes two strings
+// and scores them on a scale of 0-100 where 0 is a terrible match and
+// 100 is a great match. The block_size is used to cope with very small
+// messages. Any score below min_score may be reported as zero, which
+// lets us give up on hopeless pairs early.
 //
-int fuzzy_compare(const char *str1, const char *str2)
+static uint32_t score_strings(const char *s1,
+			      size_t len1,
+			      const uint64_t *sketch1,
+			      const char *s2,
+			      size_t len2,
+			      const uint64_t *sketch2,
+			      unsigned long block_size,
+			      uint32_t min_score)
 {
-  unsigned long block_size1, block_size2;
-  uint32_t score = 0;
-  char *s1, *s2;
-  char *s1_1, *s1_2, *s1_3;
-  char *s2_1, *s2_2, *s2_3;
+  uint32_t score, cap = 100;
+  int max_dist, dist;
 
-  if (NULL == str1 || NULL == str2)
-    return -1;
+  if (len1 > SPAMSUM_LENGTH || len2 > SPAMSUM_LENGTH) {
+    // not a real spamsum signature?
+    return 0;
+  }
 
-  // each spamsum is prefixed by its block size
-  if (sscanf(str1, "%lu:", &block_size1) != 1 ||
-      sscanf(str2, "%lu:", &block_size2) != 1) {
-    return -1;
+  // when the blocksize is small we don't want to exaggerate the match size
+  if (block_size < (99 + ROLLING_WINDOW) / ROLLING_WINDOW * MIN_BLOCKSIZE)
+    cap = MIN(cap, block_size/MIN_BLOCKSIZE * MIN(len1, len2));
+  if (cap < min_score)
+    return 0;
+
+  // the two strings must have a common substring of length
+  // ROLLING_WINDOW to be candidates, which also means neither is empty
+  if (len1 < ROLLING_WINDOW || len2 < ROLLING_WINDOW)
+    return 0;
+
+  // The distance can't be less than the difference in lengths
+  max_dist = max_distance(min_score, len1 + len2);
+  if (max_dist < 0 ||
+      (size_t)max_dist < (len1 > len2 ? len1 - len2 : len2 - len1))
+    return 0;
+
+  if (!sketches_intersect(sketch1, sketch2) ||
+      has_common_substring(s1, len1, s2, len2) == 0) {
+    return 0;
   }
 
-  // if the blocksizes don't match then we are comparing
-  // apples to oranges. This isn't an 'error' per se. We could
-  // have two valid signatures, but they can't be compared.
-  if (block_size1 != block_size2 &&
-      (block_size1 > ULONG_MAX / 2 || block_size1*2 != block_size2) &&
-      (block_size1 % 2 == 1 || block_size1 / 2 != block_size2)) {
+  // compute the edit distance between the two strings. The edit distance gives
+  // us a pretty good idea of how closely related the two strings are
+  dist = edit_distn_bp_max(s1, len1, s2, len2, max_dist);
+  if (dist > max_dist)
     return 0;
+
+  score = score_distance(dist, len1 + len2);
+
+  //  printf ("len1: %"PRIu32"  len2: %"PRIu32"\n", len1, len2);
+
+  return MIN(score, cap);
+}
+
+// if the blocksizes don't match then we are comparing
+// apples to oranges. This isn't an 'error' per se. We could
+// have two valid signatures, but they can't be compared.
+static int block_sizes_comparable(unsigned long block_size1,
+				  unsigned long block_size2)
+{
+  return (block_size1 == block_size2 ||
+	  (block_size1 <= ULONG_MAX / 2 && block_size1*2 == block_size2) ||
+	  (block_size1 % 2 == 0 && block_size1 / 2 == block_size2));
+}
+
+// Copy one part of a signature, which ends at the first character in
+// stop, into dst. There is very little information content is sequences
+// of the same character like 'LLLLL'. Eliminate any sequences longer
+// than 3. This is especially important when combined with the
+// has_common_substring() test. Returns -1 if the result does not fit,
+// unless allow_long is set, in which case only the first SPAMSUM_LENGTH
+// characters are kept and len is set to SPAMSUM_LENGTH + 1.
+static int copy_digest_part(char *dst,
+			    unsigned int *len,
+			    const char *src,
+			    const char *stop,
+			    int allow_long)
+{
+  unsigned int n = 0, run = 0;
+  char last = '\0';
+
+  for ( ; *src != '\0' && strchr(stop, *src) == NULL ; ++src)
+  {
+    if (*src != last)
+    {
+      last = *src;
+      run = 0;
+    }
+    if (++run > 3)
+      continue;
+    if (n == SPAMSUM_LENGTH && !allow_long)
+      // not a real spamsum signature
+      return -1;
+    if (n < SPAMSUM_LENGTH)
+      dst[n] = *src;
+    ++n;
   }
 
-  // move past the prefix
-  str1 = strchr(str1, ':');
-  str2 = strchr(str2, ':');
+  dst[MIN(n, SPAMSUM_LENGTH)] = '\0';
+  *len = MIN(n, SPAMSUM_LENGTH + 1);
+  return 0;
+}
 
-  if (!str1 || !str2) {
-    // badly formed ...
+static int parse_digest(struct fuzzy_parsed_digest *digest,
+			const char *str,
+			int allow_long)
+{
+  char *end;
+
+  if (NULL == digest || NULL == str)
+  {
+    errno = EINVAL;
     return -1;
   }
 
-  // there is very little information content is sequences of
-  // the same character like 'LLLLL'. Eliminate any sequences
-  // longer than 3. This is especially important when combined
-  // with the has_common_substring() test below.
-  // NOTE: This function duplciates str1 and str2
-  s1 = eliminate_sequences(str1+1);
-  if (!s1)
-    return 0;
-  s2 = eliminate_sequences(str2+1);
-  if (!s2)
+  // each spamsum is prefixed by its block size. This is the same
+  // conversion sscanf("%lu") does.
+  digest->block_size = strtoul(str, &end, 10);
+  if (end == str)
   {
-    free(s1);
-    return 0;
+    errno = EINVAL;
+    return -1;
   }
 
-  // now break them into the two pieces
-  s1_1 = s1;
-  s2_1 = s2;
-
-  s1_2 = strchr(s1, ':');
-  s2_2 = strchr(s2, ':');
+  // move past the prefix
+  str = strchr(str, ':');
+  if (NULL == str || copy_digest_part(digest->digest1, &digest->len1,
+				      str + 1, ":", allow_long) < 0)
+  {
+    errno = EINVAL;
+    return -1;
+  }
 
-  if (!s1_2 || !s2_2) {
-    // a signature is malformed - it doesn't have 2 parts
-    free(s1); free(s2);
+  // A signature without a second part is malformed. The second part
+  // ends at the comma just before the filename. If the strings don't
+  // have a comma (i.e. don't have a filename) that's ok. It's not an
+  // error. We don't care about the filename.
+  str = strchr(str + 1, ':');
+  if (NULL == str || copy_digest_part(digest->digest2, &digest->len2,
+				      str + 1, ",", allow_long) < 0)
+  {
+    errno = EINVAL;
     return -1;
   }
 
-  // Advance the pointer to the start of the second substring.
-  s1_2++;
-  s2_2++;
+  compute_sketch(digest->sketch1, digest->digest1,
+		 MIN(digest->len1, SPAMSUM_LENGTH));
+  compute_sketch(digest->sketch2, digest->digest2,
+		 MIN(digest->len2, SPAMSUM_LENGTH));
 
-  // Chop the second string at the comma--just before the filename.
-  // If the strings don't have a comma (i.e. don't have a filename)
-  // that's ok. It's not an error. This function can be called on
-  // signatures which don't have filenames attached.
-  // We also don't have to advance past the comma however. We don't care
-  // about the filename
-  s1_3 = strchr(s1_2, ',');
-  s2_3 = strchr(s2_2, ',');
-  if (s1_3 != NULL)
-    *s1_3 = 0;
-  if (s2_3 != NULL)
-    *s2_3 = 0;
+  return 0;
+}
 
-  // Now that we know the strings are both well formed, are they
-  // identical? We could save ourselves some work here
-  if (block_size1 == block_size2 && strlen(s1) == strlen(s2)) {
-    if (!strncmp(s1, s2, strlen(s1))) {
-      free (s1);
-      free (s2);
-      return 100;
+int fuzzy_parse_digest(struct fuzzy_parsed_digest *digest, const char *str)
+{
+  return parse_digest(digest, str, 0);
+}
+
+int fuzzy_parse_digest_lenient(struct fuzzy_parsed_digest *digest,
+			       const char *str)
+{
+  return parse_digest(digest, str, 1);
+}
+
+// Returns the next character of a signature, from p onwards, which
+// survives the elimination of sequences longer than 3, or '\0' at the
+// comma before the filename.
+static char next_digest_char(const char **p, char *last, unsigned int *run)
+{
+  for ( ; **p != '\0' && **p != ',' ; ++*p)
+  {
+    if (**p != *last)
+    {
+      *last = **p;
+      *run = 0;
     }
+    if (++*run <= 3)
+      return *(*p)++;
   }
+  return '\0';
+}
 
-  // Chop the first substring.
-  s1_2[-1] = 0;
-  s2_2[-1] = 0;
+// Returns nonzero if the parts of two signatures are the same once
+// sequences longer than 3 are eliminated. The parts themselves may be
+// of any length.
+static int same_digest_parts(const char *str1, const char *str2)
+{
+  char last1 = '\0', last2 = '\0', c;
+  unsigned int run1 = 0, run2 = 0;
+
+  str1 = strchr(str1, ':');
+  str2 = strchr(str2, ':');
+  do
+  {
+    c = next_digest_char(&str1, &last1, &run1);
+    if (c != next_digest_char(&str2, &last2, &run2))
+      return 0;
+  } while (c != '\0');
+
+  return 1;
+}
+
+// Score two parsed signatures. Parts which were too long are only
+// checked for being the same if check_same is set, in which case the
+// characters we kept of them have to be.
+static int compare_digests(const struct fuzzy_parsed_digest *d1,
+			   const struct fuzzy_parsed_digest *d2,
+			   int min_score,
+			   int check_same)
+{
+  unsigned long block_size1, block_size2;
+  uint32_t score = 0, min;
+
+  if (NULL == d1 || NULL == d2)
+    return -1;
+
+  min = (min_score < 0) ? 0 : (uint32_t)min_score;
+
+  block_size1 = d1->block_size;
+  block_size2 = d2->block_size;
+  if (!block_sizes_comparable(block_size1, block_size2))
+    return 0;
+
+  // Now that we know the strings are both well formed, are they
+  // identical? We could save ourselves some work here
+  if (check_same && block_size1 == block_size2 &&
+      d1->len1 == d2->len1 && d1->len2 == d2->len2 &&
+      !memcmp(d1->digest1, d2->digest1, MIN(d1->len1, SPAMSUM_LENGTH)) &&
+      !memcmp(d1->digest2, d2->digest2, MIN(d1->len2, SPAMSUM_LENGTH)))
+    return (min > 100) ? 0 : 100;
 
   // each signature has a string for two block sizes. We now
   // choose how to combine the two block sizes. We checked above
@@ -830,31 +2157,101 @@ int fuzzy_compare(const char *str1, const char *str2)
   if (block_size1 <= ULONG_MAX / 2) {
     if (block_size1 == block_size2) {
       uint32_t score1, score2;
-      score1 = score_strings(s1_1, s2_1, block_size1);
-      score2 = score_strings(s1_2, s2_2, block_size1*2);
+      score1 = score_strings(d1->digest1, d1->len1, d1->sketch1,
+			     d2->digest1, d2->len1, d2->sketch1,
+			     block_size1, min);
+      // Only a better score than score1 matters now
+      score2 = score_strings(d1->digest2, d1->len2, d1->sketch2,
+			     d2->digest2, d2->len2, d2->sketch2,
+			     block_size1*2, MAX(min, score1 + 1));
       score = MAX(score1, score2);
     }
     else if (block_size1 * 2 == block_size2) {
-      score = score_strings(s1_2, s2_1, block_size2);
+      score = score_strings(d1->digest2, d1->len2, d1->sketch2,
+			    d2->digest1, d2->len1, d2->sketch1,
+			    block_size2, min);
     }
     else {
-      score = score_strings(s1_1, s2_2, block_size1);
+      score = score_strings(d1->digest1, d1->len1, d1->sketch1,
+			    d2->digest2, d2->len2, d2->sketch2,
+			    block_size1, min);
     }
   }
   else {
     if (block_size1 == block_size2) {
-      score = score_strings(s1_1, s2_1, block_size1);
+      score = score_strings(d1->digest1, d1->len1, d1->sketch1,
+			    d2->digest1, d2->len1, d2->sketch1,
+			    block_size1, min);
     }
     else if (block_size1 % 2 == 0 && block_size1 / 2 == block_size2) {
-      score = score_strings(s1_1, s2_2, block_size1);
+      score = score_strings(d1->digest1, d1->len1, d1->sketch1,
+			    d2->digest2, d2->len2, d2->sketch2,
+			    block_size1, min);
     }
     else {
       score = 0;
     }
   }
 
-  free(s1);
-  free(s2);
+  return (score < min) ? 0 : (int)score;
+}
+
+int fuzzy_compare_digest_threshold(const struct fuzzy_parsed_digest *d1,
+				   const struct fuzzy_parsed_digest *d2,
+				   int min_score)
+{
+  return compare_digests(d1, d2, min_score, 1);
+}
+
+int fuzzy_compare_digest(const struct fuzzy_parsed_digest *d1,
+			 const struct fuzzy_parsed_digest *d2)
+{
+  return fuzzy_compare_digest_threshold(d1, d2, 0);
+}
+
+//
+// Given two spamsum strings return a value indicating the degree
+// to which they match. Scores below min_score are reported as zero.
+//
+int fuzzy_compare_threshold(const char *str1, const char *str2, int min_score)
+{
+  struct fuzzy_parsed_digest d1, d2;
+  unsigned long block_size1, block_size2;
+  char *end;
+  int long_parts;
+
+  if (NULL == str1 || NULL == str2)
+    return -1;
+
+  // Most pairs of signatures can't be compared at all, which we can
+  // tell without parsing the rest of them. This isn't an error.
+  block_size1 = strtoul(str1, &end, 10);
+  if (end == str1)
+    return -1;
+  block_size2 = strtoul(str2, &end, 10);
+  if (end == str2)
+    return -1;
+  if (!block_sizes_comparable(block_size1, block_size2))
+    return 0;
+
+  // Parts which are too long for a spamsum signature can't match
+  // anything, but the other parts of the signatures still can
+  if (parse_digest(&d1, str1, 1) != 0 ||
+      parse_digest(&d2, str2, 1) != 0)
+    return -1;
 
-  return (int)score;
+  // Only the first SPAMSUM_LENGTH characters of such parts were kept,
+  // so whether the signatures are identical is decided here
+  long_parts = (d1.len1 > SPAMSUM_LENGTH || d1.len2 > SPAMSUM_LENGTH ||
+		d2.len1 > SPAMSUM_LENGTH || d2.len2 > SPAMSUM_LENGTH);
+  if (long_parts && block_size1 == block_size2 &&
+      same_digest_parts(str1, str2))
+    return (min_score > 100) ? 0 : 100;
+
+  return compare_digests(&d1, &d2, min_score, !long_parts);
+}
+
+int fuzzy_compare(const char *str1, const char *str2)
+{
+  return fuzzy_compare_threshold(str1, str2, 0);
 }
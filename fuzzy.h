@@ -73,6 +73,11 @@ extern "C" {
  *        SPAMSUM_LENGTH/2 characters.
  */
 #define FUZZY_FLAG_NOTRUNC 0x2u
+/**
+ * @brief fuzzy_hash_fd flag allowing the file to be mapped into memory.
+ *        Only for files which can't be truncated while they are hashed.
+ */
+#define FUZZY_FLAG_MMAP 0x4u
 
 struct fuzzy_state;
 
@@ -85,6 +90,33 @@ struct fuzzy_state;
  */
 extern /*@only@*/ /*@null@*/ struct fuzzy_state *fuzzy_new(void);
 
+/**
+ * @brief Return the number of bytes a fuzzy_state object takes up.
+ *
+ * For callers which provide the memory for the state themselves, see
+ * fuzzy_init.
+ */
+extern size_t fuzzy_state_size(void);
+
+/**
+ * @brief Construct a fuzzy_state object in memory provided by the caller.
+ *
+ * The memory must hold at least fuzzy_state_size() bytes and be aligned
+ * for any type, as memory from malloc is. The state is used like one from
+ * fuzzy_new, but must not be passed to fuzzy_free. Freeing the memory is
+ * up to the caller.
+ * @return the constructed fuzzy_state, at the start of mem
+ */
+extern struct fuzzy_state *fuzzy_init(void *mem);
+
+/**
+ * @brief Return a fuzzy_state object to the state fuzzy_new gives.
+ *
+ * This allows one state to hash many inputs, one after the other,
+ * without allocating memory for each of them.
+ */
+extern void fuzzy_reset(struct fuzzy_state *state);
+
 /**
  * @brief Create a copy of a fuzzy_state object and return it.
  *
@@ -104,11 +136,26 @@ extern /*@only@*/ /*@null@*/ struct fuzzy_state *fuzzy_clone(const struct fuzzy_
  */
 extern int fuzzy_set_total_input_length(struct fuzzy_state *state, uint_least64_t total_fixed_length);
 
+/**
+ * @brief Only compute the blocksizes the fixed length of input suggests
+ *
+ * Most of the work of hashing goes into blocksizes smaller than the one
+ * the digest ends up with. After fuzzy_set_total_input_length, and before
+ * any input, this skips all but the blocksize the input length suggests
+ * and its neighbours. Should the digest need a smaller blocksize after
+ * all, fuzzy_digest fails and sets errno to ERANGE, and the input has to
+ * be hashed again with a state on which this wasn't called. Otherwise the
+ * digest is the same as without it, so it suits inputs which can be read
+ * twice, such as files.
+ * @return 0 on success or -1 on failure
+ */
+extern int fuzzy_guess_blocksize(struct fuzzy_state *state);
+
 /**
  * @brief Feed the data contained in the given buffer to the state.
  *
  * When an error occurs, the state is undefined. In that case it must not be
- * passed to any function besides fuzzy_free.
+ * passed to any function besides fuzzy_reset and fuzzy_free.
  * @param buffer The data to be hashes
  * @param buffer_size The length of the given buffer
  * @return zero on success, non-zero on error
@@ -117,6 +164,24 @@ extern int fuzzy_update(struct fuzzy_state *state,
 			const unsigned char *buffer,
 			size_t buffer_size);
 
+/**
+ * @brief Feed a buffer to each of several states at once.
+ *
+ * This has the same effect as calling fuzzy_update(states[i], buffers[i],
+ * buffer_sizes[i]) for each i, but the streams are hashed side by side,
+ * which is faster than hashing them one after another when there are
+ * many of them. The states must all be different.
+ * @param states The states to feed
+ * @param buffers The data to be hashed by each state
+ * @param buffer_sizes The length of each buffer
+ * @param count The number of states
+ * @return zero on success, non-zero on error
+ */
+extern int fuzzy_update_multi(struct fuzzy_state *const *states,
+			      const unsigned char *const *buffers,
+			      const size_t *buffer_sizes,
+			      size_t count);
+
 /**
  * @brief Obtain the fuzzy hash from the state.
  *
@@ -137,6 +202,39 @@ extern int fuzzy_digest(const struct fuzzy_state *state,
  */
 extern void fuzzy_free(/*@only@*/ struct fuzzy_state *state);
 
+/**
+ * @brief Save a fuzzy_state object as a sequence of bytes.
+ *
+ * The bytes are the same on every platform and can be turned back into
+ * the state with fuzzy_state_import, for example to continue hashing a
+ * long input after a restart or on another machine. The state itself
+ * is not changed.
+ * @param buffer Where the state is written
+ * @param buffer_size The size of buffer. FUZZY_MAX_STATE_EXPORT bytes
+ * are always enough.
+ * @return the number of bytes written, or -1 on error, with errno set to
+ * ERANGE if buffer is too small
+ */
+extern int fuzzy_state_export(const struct fuzzy_state *state,
+			      /*@out@*/ unsigned char *buffer,
+			      size_t buffer_size);
+
+/**
+ * @brief Restore a fuzzy_state object saved by fuzzy_state_export.
+ *
+ * The state, from fuzzy_new or fuzzy_init, is replaced by the saved one.
+ * Feeding it the rest of the input gives the same digest as hashing the
+ * whole input in one go would have.
+ * @param buffer The bytes written by fuzzy_state_export
+ * @param buffer_size Their number, as returned by fuzzy_state_export
+ * @return 0 on success or -1 on failure, with errno set to EINVAL if the
+ * bytes are not a state saved by a compatible version; the state is
+ * unchanged in that case
+ */
+extern int fuzzy_state_import(struct fuzzy_state *state,
+			      const unsigned char *buffer,
+			      size_t buffer_size);
+
 /**
  * @brief Compute the fuzzy hash of a buffer
  *
@@ -169,6 +267,52 @@ extern int fuzzy_hash_buf(const unsigned char *buf,
  */
 extern int fuzzy_hash_file(FILE *handle, /*@out@*/ char *result);
 
+/**
+ * @brief Compute the fuzzy hash of a file using an open handle and
+ * several threads
+ *
+ * Gives the same result as fuzzy_hash_file. A large file is split into
+ * segments which are read and hashed by up to the given number of threads
+ * at once. The file must support reading at any position. Small files,
+ * and files on systems without threads, are hashed like fuzzy_hash_file
+ * does.
+ * @param handle Open handle to the file to be hashed
+ * @param threads The largest number of threads to use
+ * @param result Where the fuzzy hash of the file is stored. This
+ * variable must be allocated to hold at least FUZZY_MAX_RESULT bytes.
+ * @return Returns zero on success, non-zero on error
+ */
+extern int fuzzy_hash_file_parallel(FILE *handle,
+				    unsigned int threads,
+				    /*@out@*/ char *result);
+
+/**
+ * @brief Compute the fuzzy hash of a regular file using an open file
+ * descriptor
+ *
+ * For callers which already know the size of the file, for example from
+ * fstat, so it isn't looked up again. The file is read in large
+ * blocks, or mapped into memory where possible if FUZZY_FLAG_MMAP is
+ * given. Large files are split between threads as
+ * fuzzy_hash_file_parallel does. Otherwise the file is first hashed as
+ * fuzzy_guess_blocksize allows, and only read a second time if the
+ * digest needs a smaller blocksize.
+ * @param fd Descriptor of the file, positioned at its start
+ * @param size Size of the file in bytes
+ * @param threads The largest number of threads to use
+ * @param result Where the fuzzy hash of the file is stored. This
+ * variable must be allocated to hold at least FUZZY_MAX_RESULT bytes.
+ * @param flags is zero or FUZZY_FLAG_MMAP. A mapped file which is
+ * truncated while it is being hashed raises SIGBUS, so the flag must
+ * not be given for files which may change.
+ * @return Returns zero on success, non-zero on error
+ */
+extern int fuzzy_hash_fd(int fd,
+			 uint_least64_t size,
+			 unsigned int threads,
+			 /*@out@*/ char *result,
+			 unsigned int flags);
+
 /**
  * @brief Compute the fuzzy hash of a stream using an open handle
  *
@@ -207,6 +351,19 @@ extern int fuzzy_hash_filename(const char *filename, /*@out@*/ char * result);
 /// inputs is NULL, returns -1.
 extern int fuzzy_compare(const char *sig1, const char *sig2);
 
+/**
+ * @brief Computes the match score between two fuzzy hash signatures,
+ * giving up on pairs which can't reach min_score.
+ *
+ * Knowing the lowest interesting score lets the comparison stop as soon
+ * as it is out of reach, which is much faster when most pairs don't match.
+ * @return Returns the same score as fuzzy_compare if it is at least
+ * min_score, and zero if it is not. When an error occurs, returns -1.
+ */
+extern int fuzzy_compare_threshold(const char *sig1,
+				   const char *sig2,
+				   int min_score);
+
 /** Length of an individual fuzzy hash signature component. */
 #define SPAMSUM_LENGTH 64
 
@@ -214,6 +371,96 @@ extern int fuzzy_compare(const char *sig1, const char *sig2);
  * (without the filename) */
 #define FUZZY_MAX_RESULT (2 * SPAMSUM_LENGTH + 20)
 
+/** The longest a fuzzy_state saved by fuzzy_state_export can be */
+#define FUZZY_MAX_STATE_EXPORT 2155
+
+/** Number of 64-bit words in the 7-gram sketch of a signature part. */
+#define FUZZY_SKETCH_WORDS 4
+
+/**
+ * @brief A fuzzy hash signature split into its parts
+ *
+ * Both parts have had sequences of more than three identical characters
+ * eliminated, just like fuzzy_compare does before scoring. Comparing two
+ * parsed signatures with fuzzy_compare_digest needs no parsing or memory
+ * allocation, so callers matching the same signatures many times should
+ * parse each of them once.
+ */
+struct fuzzy_parsed_digest
+{
+  /** The blocksize of the first part */
+  unsigned long block_size;
+  /** Length of the first part, or SPAMSUM_LENGTH + 1 if it was too long */
+  unsigned int len1;
+  /** Length of the second part, computed at twice the blocksize, or
+   * SPAMSUM_LENGTH + 1 if it was too long */
+  unsigned int len2;
+  /** The first part, NUL-terminated */
+  char digest1[SPAMSUM_LENGTH + 1];
+  /** The second part, NUL-terminated */
+  char digest2[SPAMSUM_LENGTH + 1];
+  /** A bit for each hashed 7 character substring of the first part */
+  uint64_t sketch1[FUZZY_SKETCH_WORDS];
+  /** A bit for each hashed 7 character substring of the second part */
+  uint64_t sketch2[FUZZY_SKETCH_WORDS];
+};
+
+/**
+ * @brief Split a fuzzy hash signature into a fuzzy_parsed_digest
+ *
+ * The signature has the form [blocksize]:[sig1]:[sig2] and may be
+ * followed by a comma and a filename, which is ignored.
+ * @param digest Where the parsed signature is stored
+ * @param sig The signature to parse
+ * @return Returns zero on success, -1 if the signature is malformed or
+ * either of its parts is longer than SPAMSUM_LENGTH characters once
+ * sequences are eliminated. fuzzy_compare scores such signatures anyway.
+ */
+extern int fuzzy_parse_digest(/*@out@*/ struct fuzzy_parsed_digest *digest,
+			      const char *sig);
+
+/**
+ * @brief Split a fuzzy hash signature into a fuzzy_parsed_digest, keeping
+ * signatures with parts which are too long
+ *
+ * This is fuzzy_parse_digest for signatures read from files of known
+ * hashes, which fuzzy_compare scores even if a part is longer than
+ * SPAMSUM_LENGTH characters. Only the first SPAMSUM_LENGTH characters
+ * of such a part are kept and its length is SPAMSUM_LENGTH + 1.
+ * fuzzy_compare_digest scores it as zero, just as fuzzy_compare does,
+ * but takes two such parts to be the same if the characters kept of
+ * them are.
+ * @param digest Where the parsed signature is stored
+ * @param sig The signature to parse
+ * @return Returns zero on success, -1 if the signature is malformed
+ */
+extern int fuzzy_parse_digest_lenient(/*@out@*/ struct fuzzy_parsed_digest *digest,
+				      const char *sig);
+
+/**
+ * @brief Computes the match score between two parsed signatures.
+ *
+ * This gives the same result as fuzzy_compare on the signatures the
+ * two digests were parsed from.
+ * @return Returns a value from zero to 100 indicating the match score of
+ * the two signatures, or -1 if one of the inputs is NULL.
+ */
+extern int fuzzy_compare_digest(const struct fuzzy_parsed_digest *d1,
+				const struct fuzzy_parsed_digest *d2);
+
+/**
+ * @brief Computes the match score between two parsed signatures, giving
+ * up on pairs which can't reach min_score.
+ *
+ * This is to fuzzy_compare_digest what fuzzy_compare_threshold is to
+ * fuzzy_compare.
+ * @return Returns the score if it is at least min_score, zero if it is
+ * not, or -1 if one of the inputs is NULL.
+ */
+extern int fuzzy_compare_digest_threshold(const struct fuzzy_parsed_digest *d1,
+					  const struct fuzzy_parsed_digest *d2,
+					  int min_score);
+
 #ifdef __cplusplus
 }
 #endif
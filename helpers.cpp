@@ -21,6 +21,10 @@
 
 #include "ssdeep.h"
 
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+# include <sys/mman.h>
+#endif
+
 void try_msg(void)
 {
   fprintf (stderr,"Try `%s -h` for more information.%s", __progname, NEWLINE);
@@ -352,6 +356,55 @@ int remove_escaped_quotes(char * str)
   
   return FALSE;
 }
-  
 
 
+#ifndef _WIN32
+const unsigned char * map_file(int fd, size_t size, bool& mapped)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+  void * map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (MAP_FAILED != map)
+  {
+    mapped = true;
+    return (const unsigned char *)map;
+  }
+#endif
+
+  mapped = false;
+  unsigned char * buffer = (unsigned char *)malloc(size);
+  if (NULL == buffer)
+    return NULL;
+
+  size_t done = 0;
+  while (done < size)
+  {
+    ssize_t n = read(fd, buffer + done, size - done);
+    if (n < 0 and EINTR == errno)
+      continue;
+    if (n <= 0)
+    {
+      // The file got shorter while we were reading it
+      if (0 == n)
+	errno = EINVAL;
+      free(buffer);
+      return NULL;
+    }
+    done += (size_t)n;
+  }
+
+  return buffer;
+}
+
+
+void unmap_file(const unsigned char *p, size_t size, bool mapped)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MMAP)
+  if (mapped)
+  {
+    munmap((void *)p, size);
+    return;
+  }
+#endif
+  free((void *)p);
+}
+#endif
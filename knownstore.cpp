@@ -0,0 +1,144 @@
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "knownstore.h"
+
+#include <string.h>
+
+// Words in the sketch of one part of a signature
+#define SKETCH_WORDS  FUZZY_SKETCH_WORDS
+
+
+void KnownStore::reserve(size_t count, size_t part_chars, size_t name_chars)
+{
+  count += size();
+  m_block_size.reserve(count);
+  m_len1.reserve(count);
+  m_len2.reserve(count);
+  m_parts_start.reserve(count);
+  m_sketches.reserve(count * 2 * SKETCH_WORDS);
+  m_name_start.reserve(count);
+  m_match_file.reserve(count);
+  m_cluster.reserve(count);
+  m_parts.reserve(m_parts.size() + part_chars);
+  m_names.reserve(m_names.size() + name_chars);
+}
+
+
+uint32_t KnownStore::match_file_id(const char *match_file)
+{
+  if (NULL == match_file)
+    return NO_MATCH_FILE;
+
+  if (m_last_match_file != NO_MATCH_FILE and
+      m_match_files[m_last_match_file] == match_file)
+    return m_last_match_file;
+
+  std::string name(match_file);
+  std::map<std::string,uint32_t>::const_iterator it =
+    m_match_file_ids.find(name);
+  if (it != m_match_file_ids.end())
+    m_last_match_file = it->second;
+  else
+  {
+    m_last_match_file = (uint32_t)m_match_files.size();
+    m_match_files.push_back(name);
+    m_match_file_ids[name] = m_last_match_file;
+  }
+
+  return m_last_match_file;
+}
+
+
+uint32_t KnownStore::add(const struct fuzzy_parsed_digest& d,
+			 const TCHAR * fn,
+			 const char * match_file)
+{
+  uint32_t i = size();
+
+  m_block_size.push_back(d.block_size);
+  m_len1.push_back((uint8_t)d.len1);
+  m_len2.push_back((uint8_t)d.len2);
+
+  m_parts_start.push_back(m_parts.size());
+  m_parts.insert(m_parts.end(),
+		 d.digest1, d.digest1 + kept_part_chars(d.len1));
+  m_parts.insert(m_parts.end(),
+		 d.digest2, d.digest2 + kept_part_chars(d.len2));
+  m_sketches.insert(m_sketches.end(), d.sketch1, d.sketch1 + SKETCH_WORDS);
+  m_sketches.insert(m_sketches.end(), d.sketch2, d.sketch2 + SKETCH_WORDS);
+
+  m_name_start.push_back(m_names.size());
+  m_names.insert(m_names.end(), fn, fn + _tcslen(fn) + 1);
+
+  m_match_file.push_back(match_file_id(match_file));
+  m_cluster.push_back(NO_CLUSTER);
+
+  return i;
+}
+
+
+void KnownStore::append(const KnownStore& other)
+{
+  uint64_t parts_base = m_parts.size();
+  uint64_t names_base = m_names.size();
+
+  m_block_size.insert(m_block_size.end(),
+		      other.m_block_size.begin(), other.m_block_size.end());
+  m_len1.insert(m_len1.end(), other.m_len1.begin(), other.m_len1.end());
+  m_len2.insert(m_len2.end(), other.m_len2.begin(), other.m_len2.end());
+  m_sketches.insert(m_sketches.end(),
+		    other.m_sketches.begin(), other.m_sketches.end());
+  m_cluster.insert(m_cluster.end(),
+		   other.m_cluster.begin(), other.m_cluster.end());
+  m_parts.insert(m_parts.end(), other.m_parts.begin(), other.m_parts.end());
+  m_names.insert(m_names.end(), other.m_names.begin(), other.m_names.end());
+
+  // The files of known hashes in other get the ids we have for them
+  std::vector<uint32_t> ids;
+  for (size_t i = 0 ; i < other.m_match_files.size() ; ++i)
+    ids.push_back(match_file_id(other.m_match_files[i].c_str()));
+
+  for (uint32_t i = 0 ; i < other.size() ; ++i)
+  {
+    m_parts_start.push_back(parts_base + other.m_parts_start[i]);
+    m_name_start.push_back(names_base + other.m_name_start[i]);
+    uint32_t id = other.m_match_file[i];
+    m_match_file.push_back(id == NO_MATCH_FILE ? NO_MATCH_FILE : ids[id]);
+  }
+}
+
+
+void KnownStore::get_digest(uint32_t i, struct fuzzy_parsed_digest& d) const
+{
+  // Knowns with empty parts may not have added anything to m_parts
+  const char * parts = m_parts.empty() ? "" : &m_parts[0] + m_parts_start[i];
+  const uint64_t * sketches = &m_sketches[(size_t)i * 2 * SKETCH_WORDS];
+
+  unsigned int chars1 = kept_part_chars(m_len1[i]);
+  unsigned int chars2 = kept_part_chars(m_len2[i]);
+
+  d.block_size = m_block_size[i];
+  d.len1 = m_len1[i];
+  d.len2 = m_len2[i];
+  memcpy(d.digest1, parts, chars1);
+  d.digest1[chars1] = '\0';
+  memcpy(d.digest2, parts + chars1, chars2);
+  d.digest2[chars2] = '\0';
+  memcpy(d.sketch1, sketches, sizeof(d.sketch1));
+  memcpy(d.sketch2, sketches + SKETCH_WORDS, sizeof(d.sketch2));
+}
@@ -0,0 +1,123 @@
+#ifndef __KNOWNSTORE_H
+#define __KNOWNSTORE_H
+
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "tchar-local.h"
+#include "fuzzy.h"
+#include "filedata.h"
+
+/// Match file id of a known which didn't come from a file of known hashes
+#define NO_MATCH_FILE  UINT32_MAX
+
+/// Returns the number of characters kept for a part of a signature of
+/// length len. A part which was too long has only its first
+/// SPAMSUM_LENGTH characters, but a length of SPAMSUM_LENGTH + 1.
+inline unsigned int kept_part_chars(unsigned int len)
+{
+  return (len > SPAMSUM_LENGTH) ? SPAMSUM_LENGTH : len;
+}
+
+/// @brief The set of known hashes, kept as one array for each field
+/// rather than as an object for each known.
+///
+/// Knowns are referred to by their index, which is the order in which
+/// they were added. The signature parts of all of the knowns are kept
+/// end to end in one block, as are their filenames, and each file of
+/// known hashes is named once however many knowns came from it. That
+/// keeps the knowns small and lets the comparison loops walk them in
+/// order.
+class KnownStore
+{
+ public:
+  KnownStore() : m_last_match_file(NO_MATCH_FILE) {}
+
+  /// Returns the number of knowns
+  uint32_t size(void) const { return (uint32_t)m_block_size.size(); }
+
+  /// Returns the number of characters in the parts of all of the knowns
+  size_t part_chars(void) const { return m_parts.size(); }
+  /// Returns the number of characters in the names of all of the
+  /// knowns, including their NULs
+  size_t name_chars(void) const { return m_names.size(); }
+
+  /// Makes room for count more knowns, whose parts take up part_chars
+  /// characters and whose names take up name_chars characters
+  void reserve(size_t count, size_t part_chars, size_t name_chars);
+
+  /// @brief Add a known with the parsed signature d and the name fn,
+  /// which came from the file of known hashes match_file. match_file
+  /// may be NULL.
+  ///
+  /// @return Returns the index of the new known
+  uint32_t add(const struct fuzzy_parsed_digest& d,
+	       const TCHAR * fn,
+	       const char * match_file);
+
+  /// Add all of the knowns in other, in order, after the ones we have
+  void append(const KnownStore& other);
+
+  /// Fills in d with the parsed signature of known i, ready to be passed
+  /// to fuzzy_compare_digest()
+  void get_digest(uint32_t i, struct fuzzy_parsed_digest& d) const;
+
+  /// Returns the blocksize of known i
+  unsigned long get_block_size(uint32_t i) const { return m_block_size[i]; }
+
+  /// Returns the name of known i. The name moves when knowns are added,
+  /// so the pointer is only good until then.
+  const TCHAR * get_filename(uint32_t i) const
+  { return &m_names[m_name_start[i]]; }
+
+  /// Returns true if known i came from a file of known hashes
+  bool has_match_file(uint32_t i) const
+  { return (m_match_file[i] != NO_MATCH_FILE); }
+  /// Returns the name of the file of known hashes known i came from
+  const std::string& get_match_file(uint32_t i) const
+  { return m_match_files[m_match_file[i]]; }
+
+  /// Returns true if known i belongs to a cluster of similar files
+  bool has_cluster(uint32_t i) const { return (m_cluster[i] != NO_CLUSTER); }
+  /// Records the node for known i in the disjoint sets of clusters
+  void set_cluster(uint32_t i, uint32_t node) { m_cluster[i] = node; }
+  uint32_t get_cluster(uint32_t i) const { return m_cluster[i]; }
+
+ private:
+  uint32_t match_file_id(const char *match_file);
+
+  // One entry for each known
+  std::vector<unsigned long> m_block_size;
+  std::vector<uint8_t>       m_len1;
+  std::vector<uint8_t>       m_len2;
+  /// Where the parts of the known start in m_parts
+  std::vector<uint64_t>      m_parts_start;
+  /// The sketches of both parts of each known, one after the other
+  std::vector<uint64_t>      m_sketches;
+  /// Where the name of the known starts in m_names
+  std::vector<uint64_t>      m_name_start;
+  std::vector<uint32_t>      m_match_file;
+  std::vector<uint32_t>      m_cluster;
+
+  /// The first and second parts of each known, without separators
+  std::vector<char>          m_parts;
+  /// The names of the knowns, each followed by a NUL
+  std::vector<TCHAR>         m_names;
+
+  /// The files of known hashes, by id
+  std::vector<std::string>   m_match_files;
+  std::map<std::string,uint32_t> m_match_file_ids;
+  /// Most knowns come from the same file as the one before them
+  uint32_t                   m_last_match_file;
+};
+
+#endif   // ifndef __KNOWNSTORE_H
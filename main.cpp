@@ -10,6 +10,8 @@
 
 #include "ssdeep.h"
 #include "match.h"
+#include "sigdb.h"
+#include "server.h"
 
 #ifdef _WIN32 
 // This can't go in main.h or we get multiple definitions of it
@@ -30,6 +32,11 @@ static bool initialize_state(state *s)
   s->processed_file        = false;
 
   s->threshold = 0;
+  s->threads   = 1;
+  s->deferred_directory = false;
+  s->walker = NULL;
+  s->cache  = NULL;
+  s->client = NULL;
 
   return false;
 }
@@ -42,7 +49,7 @@ static void usage(void)
   print_status ("%s version %s by Jesse Kornblum", __progname, VERSION);
   print_status ("Copyright (C) 2014 Facebook");
   print_status ("");
-  print_status ("Usage: %s [-m file] [-k file] [-dpgvrsblcxa] [-t val] [-h|-V] [FILES]", 
+  print_status ("Usage: %s [-m file] [-k file] [-C file] [-M file] [-S file] [-dpgvrsblcxa] [-t val] [-j num] [-h|-V] [FILES]", 
 	  __progname);
 
   print_status ("-m - Match FILES against known hashes in file");
@@ -61,6 +68,10 @@ static void usage(void)
   print_status ("-a - Display all matches, regardless of score");
 
   print_status ("-t - Only displays matches above the given threshold");
+  print_status ("-j - Number of threads to use for hashing and matching");
+  print_status ("-C - Keep signatures in file and reuse them for unchanged files");
+  print_status ("-M - Write the known hashes from -m to file as a database and exit");
+  print_status ("-S - With -m, answer queries on socket file; otherwise query it");
 
   print_status ("-h - Display this help message");
   print_status ("-V - Display version number and exit");
@@ -70,8 +81,10 @@ static void usage(void)
 static void process_cmd_line(state *s, int argc, char **argv)
 {
   int i, match_files_loaded = FALSE;
+  const char * database_fn = NULL;
+  const char * server_fn = NULL;
 
-  while ((i=getopt(argc,argv,"gavhVpdsblcxt:rm:k:")) != -1) {
+  while ((i=getopt(argc,argv,"gavhVpdsblcxt:rm:k:j:C:M:S:")) != -1) {
     switch(i) {
       
     case 'g':
@@ -127,6 +140,18 @@ static void process_cmd_line(state *s, int argc, char **argv)
       s->mode |= mode_threshold;
       break;
       
+    case 'j':
+      {
+	char * end;
+	errno = 0;
+	long threads = strtol(optarg, &end, 10);
+	if (errno or end == optarg or *end != '\0' or
+	    threads < 1 or threads > SSDEEP_MAX_THREADS)
+	  fatal_error("%s: Illegal number of threads", __progname);
+	s->threads = (unsigned int)threads;
+      }
+      break;
+
     case 'm':
       if (MODE(mode_compare_unknown) || MODE(mode_sigcompare))
 	fatal_error("Positive matching cannot be combined with other matching modes");
@@ -143,6 +168,36 @@ static void process_cmd_line(state *s, int argc, char **argv)
 	match_files_loaded = TRUE;
       break;
 
+    case 'C':
+#ifdef _WIN32
+      fatal_error("%s: The signature cache is not available on Windows", 
+		  __progname);
+#else
+      if (NULL != s->cache)
+	fatal_error("%s: Only one signature cache can be used", __progname);
+      s->cache = new HashCache;
+      if (s->cache->load(optarg))
+	fatal_error("%s: %s: %s", __progname, optarg, strerror(errno));
+#endif
+      break;
+
+    case 'M':
+#ifdef _WIN32
+      fatal_error("%s: Databases are not available on Windows", __progname);
+#else
+      database_fn = optarg;
+#endif
+      break;
+
+    case 'S':
+#ifdef _WIN32
+      fatal_error("%s: The match server is not available on Windows", 
+		  __progname);
+#else
+      server_fn = optarg;
+#endif
+      break;
+
     case 'h':
       usage(); 
       exit (EXIT_SUCCESS);
@@ -185,7 +240,44 @@ static void process_cmd_line(state *s, int argc, char **argv)
 		(MODE(mode_compare_unknown) or MODE(mode_sigcompare))),
 	       "Incompatible matching modes");
 
+  // With more than one thread, directory mode compares all of the files
+  // at once after they have been hashed, rather than each one as we go.
+  // The output is the same.
+  s->deferred_directory = (MODE(mode_directory) and not MODE(mode_match)
+			   and s->threads > 1);
+
+  if (NULL != database_fn) {
+    sanity_check(s, not MODE(mode_match), "Databases are written from -m");
+    if (sigdb_write(s, database_fn, true))
+      fatal_error("%s: %s: %s", __progname, database_fn, strerror(errno));
+    exit(EXIT_SUCCESS);
+  }
 
+#ifndef _WIN32
+  if (NULL != server_fn) {
+    if (MODE(mode_match)) {
+      sanity_check(s,
+		   MODE(mode_match_pretty) or MODE(mode_directory) or 
+		   MODE(mode_cluster),
+		   "The match server only does positive matching");
+      server_run(s, server_fn);
+      fatal_error("%s: %s: %s", __progname, server_fn, strerror(errno));
+    }
+
+    sanity_check(s,
+		 MODE(mode_compare_unknown) or MODE(mode_sigcompare) or
+		 MODE(mode_match_pretty) or MODE(mode_directory) or 
+		 MODE(mode_cluster),
+		 "The match server does the matching for its clients");
+    // The server's threshold and output format apply to every query
+    sanity_check(s,
+		 MODE(mode_threshold) or MODE(mode_display_all) or
+		 MODE(mode_csv),
+		 "The threshold and the -a and -c flags are set by the match server");
+    if (client_connect(s, server_fn))
+      fatal_error("%s: %s: %s", __progname, server_fn, strerror(errno));
+  }
+#endif
 }
 
 
@@ -305,16 +397,27 @@ int main(int argc, char **argv)
       else {
 	generate_filename(s, fn, cwd, s->argv[count]);
 	
+	if (s->threads > 1)
+	  status = process_parallel(s, fn);
+	else
+	{
 #ifdef _WIN32
-	status = process_win32(s, fn);
+	  status = process_win32(s, fn);
 #else
-	status = process_normal(s, fn);
+	  status = process_normal(s, fn);
 #endif
+	}
       }
       
       ++count;
     }
 
+    process_parallel_done(s);
+
+    if (NULL != s->cache and s->cache->save())
+      print_error(s, "%s: Unable to save signature cache: %s", 
+		  __progname, strerror(errno));
+
     // If we processed files, but didn't find anything large enough
     // to be meaningful, we should display a warning message to the user.
     // This happens mostly when people are testing very small files
@@ -329,6 +432,8 @@ int main(int argc, char **argv)
   // If the user has requested us to compare signature files, use
   // our existng code to pretty-print directory matching to do the
   // work for us.
+  if (s->deferred_directory)
+    find_matches_in_directory(s);
   if (MODE(mode_sigcompare))
     s->mode |= mode_match_pretty;
   if (MODE(mode_match_pretty) or MODE(mode_sigcompare) or MODE(mode_cluster))
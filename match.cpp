@@ -19,6 +19,7 @@
 
 
 #include "match.h"
+#include "sigdb.h"
 
 // The longest line we should encounter when reading files of known hashes 
 #define MAX_STR_LEN  2048
@@ -148,19 +149,130 @@ bool sig_file_end(state *s)
 // MATCHING FUNCTIONS
 // ------------------------------------------------------------------
 
+// Follow the parents from node up to the root of its cluster
+static uint32_t cluster_find(const state *s, uint32_t node)
+{
+  while (s->cluster_parent[node] != node)
+    node = s->cluster_parent[node];
+  return node;
+}
+
+
+// As cluster_find, but also points every other node on the way
+// at its grandparent, which keeps the trees shallow
+static uint32_t cluster_find_compress(state *s, uint32_t node)
+{
+  while (s->cluster_parent[node] != node)
+  {
+    s->cluster_parent[node] = s->cluster_parent[s->cluster_parent[node]];
+    node = s->cluster_parent[node];
+  }
+  return node;
+}
+
+
+static file_ref known_ref(uint32_t i)
+{
+  file_ref r;
+  r.f = NULL;
+  r.known = i;
+  return r;
+}
+
+
+static file_ref unknown_ref(Filedata *f)
+{
+  file_ref r;
+  r.f = f;
+  r.known = 0;
+  return r;
+}
+
+
+static const TCHAR * ref_filename(const state *s, const file_ref& r)
+{
+  return r.f ? r.f->get_filename() : s->all_files.get_filename(r.known);
+}
+
+
+static bool ref_has_match_file(const state *s, const file_ref& r)
+{
+  return r.f ? r.f->has_match_file() : s->all_files.has_match_file(r.known);
+}
+
+
+static const std::string& ref_match_file(const state *s, const file_ref& r)
+{
+  return r.f ? r.f->get_match_file() : s->all_files.get_match_file(r.known);
+}
+
+
+// Returns the parsed signature of r. Knowns are unpacked into tmp.
+static const struct fuzzy_parsed_digest& 
+ref_digest(const state *s, const file_ref& r, struct fuzzy_parsed_digest& tmp)
+{
+  if (r.f)
+    return r.f->get_digest();
+  s->all_files.get_digest(r.known, tmp);
+  return tmp;
+}
+
+
+// Returns the node for r, giving it one in a cluster of its own
+// if it doesn't have one yet
+static uint32_t cluster_node(state *s, const file_ref& r)
+{
+  bool found = r.f ? r.f->has_cluster() : s->all_files.has_cluster(r.known);
+  if (not found)
+  {
+    uint32_t node = (uint32_t)s->cluster_files.size();
+    s->cluster_files.push_back(r);
+    s->cluster_parent.push_back(node);
+    s->cluster_rank.push_back(0);
+    if (r.f)
+      r.f->set_cluster(node);
+    else
+      s->all_files.set_cluster(r.known, node);
+  }
+
+  return r.f ? r.f->get_cluster() : s->all_files.get_cluster(r.known);
+}
+
+
 void display_clusters(const state *s)
 {
   if (NULL == s)
     return;
 
-  std::set<std::set<Filedata *> *>::const_iterator it;
-  for (it = s->all_clusters.begin(); it != s->all_clusters.end() ; ++it)
+  // Gather the members of each cluster. The clusters are displayed in
+  // the order in which their first member joined one, and their members
+  // in the order in which they joined.
+  uint32_t total = (uint32_t)s->cluster_files.size();
+  std::vector<uint32_t> root(total), start(total + 1, 0), members(total);
+  for (uint32_t i = 0 ; i < total ; ++i)
   {
-    print_status("** Cluster size %u", (*it)->size());
-    std::set<Filedata *>::const_iterator cit;
-    for (cit = (*it)->begin() ; cit != (*it)->end() ; ++cit)
+    root[i] = cluster_find(s, i);
+    start[root[i] + 1]++;
+  }
+  for (uint32_t i = 0 ; i < total ; ++i)
+    start[i + 1] += start[i];
+  std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+  for (uint32_t i = 0 ; i < total ; ++i)
+    members[fill[root[i]]++] = i;
+
+  std::vector<bool> shown(total, false);
+  for (uint32_t i = 0 ; i < total ; ++i)
+  {
+    if (shown[root[i]])
+      continue;
+    shown[root[i]] = true;
+
+    print_status("** Cluster size %u", start[root[i] + 1] - start[root[i]]);
+    for (uint32_t m = start[root[i]] ; m < start[root[i] + 1] ; ++m)
     {
-      display_filename(stdout,(*cit)->get_filename(),FALSE);
+      display_filename(stdout,
+		       ref_filename(s, s->cluster_files[members[m]]),
+		       FALSE);
       print_status("");
     }
     
@@ -169,118 +281,225 @@ void display_clusters(const state *s)
 }
 
 
-void cluster_add(Filedata * dest, Filedata * src)
+void handle_clustering(state *s, const file_ref& a, const file_ref& b)
 {
-  dest->get_cluster()->insert(src);
-  src->set_cluster(dest->get_cluster());
-}
+  uint32_t ra = cluster_find_compress(s, cluster_node(s, a));
+  uint32_t rb = cluster_find_compress(s, cluster_node(s, b));
 
-
-void cluster_join(state *s, Filedata * a, Filedata * b)
-{
   // If these items are already in the same cluster there is nothing to do
-  if (a->get_cluster() == b->get_cluster())
+  if (ra == rb)
     return;
 
-  Filedata * dest, * src;
-  // Combine the smaller cluster into the larger cluster for speed
-  // (fewer items to move)
-  if (a->get_cluster()->size() > b->get_cluster()->size())
+  // Hang the shallower tree under the deeper one
+  if (s->cluster_rank[ra] < s->cluster_rank[rb])
+    std::swap(ra, rb);
+  s->cluster_parent[rb] = ra;
+  if (s->cluster_rank[ra] == s->cluster_rank[rb])
+    s->cluster_rank[ra]++;
+}
+
+
+
+// Display a match as we do outside of clustering mode
+static void display_match(FILE *out,
+			  const state *s,
+			  const file_ref& a,
+			  const file_ref& b,
+			  int score)
+{
+  if (s->mode & mode_csv)
   {
-    dest = a; 
-    src  = b;
+    fprintf(out,"\"");
+    display_filename(out,ref_filename(s,a),TRUE);
+    fprintf(out,"\",\"");
+    display_filename(out,ref_filename(s,b),TRUE);
+    fprintf(out,"\",%u%s", score, NEWLINE);
   }
   else
   {
-    dest = b; 
-    src  = a;
+    // The match file names may be empty. If so, we don't print them
+    // or the colon which separates them from the filename
+    if (ref_has_match_file(s,a))
+      fprintf (out,"%s:", ref_match_file(s,a).c_str());
+    display_filename(out,ref_filename(s,a),FALSE);
+    fprintf (out," matches ");
+    if (ref_has_match_file(s,b))
+      fprintf (out,"%s:", ref_match_file(s,b).c_str());
+    display_filename(out,ref_filename(s,b),FALSE);
+    fprintf (out," (%u)%s", score, NEWLINE);
   }
+}
+
+
+void handle_match(state *s, 
+		  const file_ref& a, 
+		  const file_ref& b, 
+		  int score)
+{
+  if (s->mode & mode_cluster)
+    handle_clustering(s,a,b);
+  else
+    display_match(stdout,s,a,b,score);
+}
+
+
+// True if the two parsed signatures are the same
+static bool same_digest(const struct fuzzy_parsed_digest& a,
+			const struct fuzzy_parsed_digest& b)
+{
+  return (a.block_size == b.block_size and
+	  a.len1 == b.len1 and
+	  a.len2 == b.len2 and
+	  0 == memcmp(a.digest1, b.digest1, a.len1) and
+	  0 == memcmp(a.digest2, b.digest2, a.len2));
+}
+
 
-  // Add members of src to dest
-  std::set<Filedata *>::const_iterator it;
-  for (it =  src->get_cluster()->begin() ; 
-       it != src->get_cluster()->end() ; 
-       ++it)
+// When in pretty mode, we still want to avoid printing
+// A matches A (100).
+static bool is_self_match(const state *s, 
+			  const file_ref& f, 
+			  size_t fn_len, 
+			  const file_ref& known)
+{
+  if (not (s->mode & mode_match_pretty))
+    return false;
+
+  const TCHAR * known_fn = ref_filename(s, known);
+  if (_tcsncmp(ref_filename(s, f), known_fn, std::max(fn_len,_tcslen(known_fn))))
+    return false;
+
+  struct fuzzy_parsed_digest tmp_f, tmp_known;
+  if (same_digest(ref_digest(s, f, tmp_f), ref_digest(s, known, tmp_known)))
   {
-    dest->get_cluster()->insert(*it);
+    // Unless these results from different matching files (such as
+    // what happens in sigcompare mode). That being said, we have to
+    // be careful to avoid NULL values such as when working in 
+    // normal pretty print mode.
+    if (not(ref_has_match_file(s, f)) or 
+	(ref_has_match_file(s, known) and
+	 ref_match_file(s, f) == ref_match_file(s, known)))
+      return true;
   }
 
-  // Remove the old cluster
-  s->all_clusters.erase(src->get_cluster());
-  // This call sets the cluster to NULL. Do not access the src
-  // cluster after this call!
-  src->clear_cluster();
-
-  src->set_cluster(dest->get_cluster());
+  return false;
 }
 
 
-void handle_clustering(state *s, Filedata *a, Filedata *b)
+// The lowest score worth computing exactly. Only scores above the
+// threshold get displayed, unless we're displaying everything.
+static int min_score(const state *s)
 {
-  bool a_has = a->has_cluster(), b_has = b->has_cluster();
+  return MODE(mode_display_all) ? 0 : s->threshold + 1;
+}
+
 
-  // In the easiest case, one of these has a cluster and one doesn't
-  if (a_has and not b_has)
+// Display the score of f against known if it's good enough. Returns
+// true if a match was displayed.
+static bool report_score(state *s, 
+			 const file_ref& f, 
+			 const file_ref& known, 
+			 int score)
+{
+  if (-1 == score)
+    print_error(s, "%s: Bad hashes in comparison", __progname);
+  else
   {
-    cluster_add(a,b);
-    return;
+    if (score > s->threshold or MODE(mode_display_all))
+    {
+      handle_match(s,f,known,score);
+      return true;
+    }
   }
-  if (b_has and not a_has)
+
+  return false;
+}
+
+
+void match_score(const state *s, 
+		 const struct fuzzy_parsed_digest& d,
+		 std::vector<std::pair<uint32_t,int> >& scores)
+{
+  if (NULL == s)
+    fatal_error("%s: Null state passed into match_score", __progname);
+
+  scores.clear();
+  std::vector<uint32_t> ids;
+  std::vector<uint32_t>::const_iterator it;
+  struct fuzzy_parsed_digest known;
+
+  if (MODE(mode_display_all))
   {
-    cluster_add(b,a);
+    // Every known gets displayed, but only those in the bs/2, bs and
+    // 2*bs buckets need to be scored.
+    s->known_index.comparable(d, ids);
+    it = ids.begin();
+    for (uint32_t i = 0 ; i < s->all_files.size() ; ++i)
+    {
+      int score = 0;
+      if (it != ids.end() and *it == i)
+      {
+	s->all_files.get_digest(i, known);
+	score = fuzzy_compare_digest_threshold(&d, &known, 0);
+	++it;
+      }
+      scores.push_back(std::make_pair(i, score));
+    }
+
     return;
   }
-  
-  // Combine existing clusters
-  if (a_has and b_has)
+
+  // Only knowns which share a 7-gram with f can score above zero. 
+  s->known_index.candidates(d, ids);
+  for (it = ids.begin() ; it != ids.end() ; ++it)
   {
-    cluster_join(s,a,b);
-    return;
+    s->all_files.get_digest(*it, known);
+    int score = fuzzy_compare_digest_threshold(&d, &known, min_score(s));
+    if (score != 0)
+      scores.push_back(std::make_pair(*it, score));
   }
+}
 
-  // Create a new cluster
-  std::set<Filedata *> * cluster = new std::set<Filedata *>();
-  cluster->insert(a);
-  cluster->insert(b);
 
-  s->all_clusters.insert(cluster);
+bool match_report(state *s, 
+		  Filedata * f,
+		  const std::vector<std::pair<uint32_t,int> >& scores)
+{
+  bool status = false;  
+  size_t fn_len = _tcslen(f->get_filename());
+  std::vector<std::pair<uint32_t,int> >::const_iterator it;
 
-  a->set_cluster(cluster);
-  b->set_cluster(cluster);
-}
+  for (it = scores.begin() ; it != scores.end() ; ++it)
+  {
+    file_ref known = known_ref(it->first);
+    if (not is_self_match(s, unknown_ref(f), fn_len, known))
+      status |= report_score(s, unknown_ref(f), known, it->second);
+  }
 
+  return status;
+}
 
 
-void handle_match(state *s, 
-		  Filedata *a, 
-		  Filedata *b, 
-		  int score)
+bool match_write(FILE *out, 
+		 const state *s, 
+		 Filedata * f,
+		 const std::vector<std::pair<uint32_t,int> >& scores)
 {
-  if (s->mode & mode_csv)
-  {
-    printf("\"");
-    display_filename(stdout,a->get_filename(),TRUE);
-    printf("\",\"");
-    display_filename(stdout,b->get_filename(),TRUE);
-    print_status("\",%u", score);
-  }
-  else if (s->mode & mode_cluster)
-  {
-    handle_clustering(s,a,b);
-  }
-  else
+  bool status = false;
+  std::vector<std::pair<uint32_t,int> >::const_iterator it;
+
+  for (it = scores.begin() ; it != scores.end() ; ++it)
   {
-    // The match file names may be empty. If so, we don't print them
-    // or the colon which separates them from the filename
-    if (a->has_match_file())
-      printf ("%s:", a->get_match_file().c_str());
-    display_filename(stdout,a->get_filename(),FALSE);
-    printf (" matches ");
-    if (b->has_match_file())
-      printf ("%s:", b->get_match_file().c_str());
-    display_filename(stdout,b->get_filename(),FALSE);
-    print_status(" (%u)", score);
+    if (-1 == it->second)
+      continue;
+    if (it->second > s->threshold or MODE(mode_display_all))
+    {
+      display_match(out, s, unknown_ref(f), known_ref(it->first), it->second);
+      status = true;
+    }
   }
+
+  return status;
 }
 
 
@@ -289,59 +508,93 @@ bool match_compare(state *s, Filedata * f)
   if (NULL == s)
     fatal_error("%s: Null state passed into match_compare", __progname);
 
-  bool status = false;  
-  size_t fn_len = _tcslen(f->get_filename());
+  std::vector<std::pair<uint32_t,int> > scores;
+  match_score(s, f->get_digest(), scores);
+  return match_report(s, f, scores);
+}
+  
+
+// Display f against known unless it's f itself in pretty mode
+static bool report_pair(state *s, 
+			const file_ref& f, 
+			size_t fn_len, 
+			const file_ref& known, 
+			int score)
+{
+  if (is_self_match(s, f, fn_len, known))
+    return false;
+  return report_score(s, f, known, score);
+}
+
 
-  std::vector<Filedata* >::const_iterator it;
-  for (it = s->all_files.begin() ; it != s->all_files.end() ; ++it)
+// Display the matches for known i from a table of all pairs. Only the
+// knowns before i are considered when limit is i, all of them when
+// limit is the number of knowns.
+static bool display_pairs(state *s, 
+			  const pair_table& t, 
+			  uint32_t i, 
+			  uint32_t limit)
+{
+  file_ref f = known_ref(i);
+  size_t fn_len = _tcslen(s->all_files.get_filename(i));
+  bool status = false;
+  uint32_t m = t.start[i], stop = t.start[i + 1];
+
+  // Files aren't compared to themselves in the table
+  struct fuzzy_parsed_digest d;
+  s->all_files.get_digest(i, d);
+  int self_score = fuzzy_compare_digest_threshold(&d, &d, min_score(s));
+
+  if (MODE(mode_display_all))
   {
-    // When in pretty mode, we still want to avoid printing
-    // A matches A (100).
-    if (s->mode & mode_match_pretty)
+    // Every known gets displayed, the ones missing from the table
+    // with a score of zero.
+    for (uint32_t j = 0 ; j < limit ; ++j)
     {
-      if (!(_tcsncmp(f->get_filename(),
-		     (*it)->get_filename(),
-		     std::max(fn_len,_tcslen((*it)->get_filename())))) and
-	  (f->get_signature() == (*it)->get_signature()))
-      {
-	// Unless these results from different matching files (such as
-	// what happens in sigcompare mode). That being said, we have to
-	// be careful to avoid NULL values such as when working in 
-	// normal pretty print mode.
-	if (not(f->has_match_file()) or 
-	    f->get_match_file() == (*it)->get_match_file())
-	  continue;
-      }
+      int score = 0;
+      if (j == i)
+	score = self_score;
+      else if (m < stop and t.matches[m].first == j)
+	score = t.matches[m++].second;
+      status |= report_pair(s, f, fn_len, known_ref(j), score);
     }
 
-    int score =  fuzzy_compare(f->get_signature().c_str(), 
-			       (*it)->get_signature().c_str());
-    if (-1 == score)
-      print_error(s, "%s: Bad hashes in comparison", __progname);
-    else
+    return status;
+  }
+
+  // Otherwise f goes in its place among the matches
+  bool self_pending = (i < limit);
+  for ( ; m < stop and t.matches[m].first < limit ; ++m)
+  {
+    uint32_t j = t.matches[m].first;
+    if (self_pending and i < j)
     {
-      if (score > s->threshold or MODE(mode_display_all))
-      {
-	handle_match(s,f,(*it),score);
-	status = true;
-      }
+      status |= report_pair(s, f, fn_len, f, self_score);
+      self_pending = false;
     }
+    status |= report_pair(s, f, fn_len, known_ref(j), t.matches[m].second);
   }
-  
+  if (self_pending)
+    status |= report_pair(s, f, fn_len, f, self_score);
+
   return status;
 }
-  
+
 
 bool find_matches_in_known(state *s)
 {
   if (NULL == s)
     return true;
 
+  pair_table t;
+  if (match_all_pairs(s, min_score(s), t))
+    return true;
+
   // Walk the vector which contains all of the known files
-  std::vector<Filedata *>::const_iterator it;
-  for (it = s->all_files.begin() ; it != s->all_files.end() ; ++it)
+  uint32_t total = s->all_files.size();
+  for (uint32_t i = 0 ; i < total ; ++i)
   {
-    bool status = match_compare(s,*it);
+    bool status = display_pairs(s, t, i, total);
     // In pretty mode and sigcompare mode we need to display a blank
     // line after each file. In clustering mode we don't display anything
     // right now.
@@ -353,11 +606,39 @@ bool find_matches_in_known(state *s)
 }
 
 
-bool match_add(state *s, Filedata * f) {
+bool find_matches_in_directory(state *s)
+{
   if (NULL == s)
     return true;
 
-  s->all_files.push_back(f);
+  pair_table t;
+  if (match_all_pairs(s, min_score(s), t))
+    return true;
+
+  uint32_t total = s->all_files.size();
+  for (uint32_t i = 0 ; i < total ; ++i)
+    display_pairs(s, t, i, i);
+
+  return false;
+}
+
+
+bool match_add(state *s, Filedata * f) {
+  if (NULL == s or NULL == f)
+    return true;
+
+  const char * match_file = 
+    f->has_match_file() ? f->get_match_file().c_str() : NULL;
+  uint32_t i = s->all_files.add(f->get_digest(), f->get_filename(), match_file);
+  s->known_index.insert(i, f->get_digest());
+
+  // The known takes the place of f in its cluster, so f can be freed
+  if (f->has_cluster())
+  {
+    s->all_files.set_cluster(i, f->get_cluster());
+    s->cluster_files[f->get_cluster()] = known_ref(i);
+    f->set_cluster(NO_CLUSTER);
+  }
 
   return false;
 }
@@ -366,6 +647,17 @@ bool match_add(state *s, Filedata * f) {
 bool match_load(state *s, const char *fn) {
   if (NULL == s or NULL == fn)
     return true;
+
+#ifndef _WIN32
+  if (sigdb_is_database(fn))
+    return sigdb_load(s,fn);
+
+  // Files which can be brought into memory are parsed all at once. Pipes
+  // and the like are read a line at a time.
+  struct stat sb;
+  if (0 == stat(fn, &sb) and S_ISREG(sb.st_mode) and sb.st_size > 0)
+    return sig_file_load(s,fn);
+#endif
   
   if (sig_file_open(s,fn))
     return true;
@@ -376,7 +668,9 @@ bool match_load(state *s, const char *fn) {
     Filedata * f; 
     status = sig_file_next(s,&f);
     if (not status) {
-      if (match_add(s,f)) {
+      bool error = match_add(s,f);
+      delete f;
+      if (error) {
 	// One bad hash doesn't mean this load was a failure.
 	// We don't change the return status because match_add failed.
 	print_error(s, "%s: unable to insert hash", fn);
@@ -406,11 +700,15 @@ bool match_compare_unknown(state *s, const char * fn)
     Filedata *f;
     status = sig_file_next(s,&f);
     if (not status)
+    {
       match_compare(s,f);
+      // A file in a cluster is still needed to display it
+      if (not f->has_cluster())
+	delete f;
+    }
   } while (not sig_file_end(s));
 
   sig_file_close(s);
 
   return false;
 }
-
@@ -19,19 +19,80 @@
 /// @param f Filedata structure for the file.
 bool match_compare(state *s, Filedata * f);
 
+/// @brief Score a signature against the set of knowns, as match_compare()
+/// does, without displaying anything. The state is only read, so this
+/// can run on several threads at once.
+///
+/// @param s State variable
+/// @param d The parsed signature
+/// @param scores Set to the index of each known worth displaying and its
+/// score, in order of index
+void match_score(const state *s, 
+		 const struct fuzzy_parsed_digest& d,
+		 std::vector<std::pair<uint32_t,int> >& scores);
+
+/// @brief Display the matches for f found by match_score()
+///
+/// @return Returns false if there are no matches, true if at least one match
+bool match_report(state *s, 
+		  Filedata * f,
+		  const std::vector<std::pair<uint32_t,int> >& scores);
+
+/// @brief Write the matches for f found by match_score() to out, as
+/// match_report() displays them in positive matching mode. The state is
+/// only read, so this can run on several threads at once.
+///
+/// @return Returns false if there are no matches, true if at least one match
+bool match_write(FILE *out, 
+		 const state *s, 
+		 Filedata * f,
+		 const std::vector<std::pair<uint32_t,int> >& scores);
+
 /// @brief Load a file of known hashes
 ///
 /// @return Returns false on success, true on error
 bool match_load(state *s, const char *fn);
 
+/// @brief Load a file of known hashes, which must be a regular file, as
+/// match_load() does. The file is brought into memory and parsed by
+/// s->threads threads. Not available on Windows.
+///
+/// @return Returns false on success, true on error
+bool sig_file_load(state *s, const char *fn);
+
 /// @brief Add a single new hash to the set of known hashes
 ///
+/// The known is a copy of f, which also takes over the place of f in its
+/// cluster, if any. The caller still owns f.
+///
 /// @return Returns false on success, true on error
 bool match_add(state *s, Filedata * f);
 
 /// Find and display all matches in the set of known hashes
 bool find_matches_in_known(state *s);
 
+/// @brief Display the matches directory mode would have displayed while
+/// the files were being hashed, where each file is compared to those
+/// before it.
+///
+/// @return Returns false on success, true on error
+bool find_matches_in_directory(state *s);
+
+/// The scores of all pairs of known hashes which are worth displaying
+typedef struct
+{
+  /// The matches for known i are matches[start[i]] to matches[start[i+1]-1]
+  std::vector<uint32_t> start;
+  /// Index of the other known and the score, in order of index
+  std::vector<std::pair<uint32_t,int> > matches;
+} pair_table;
+
+/// @brief Score every pair of known hashes, using s->threads threads.
+/// Pairs which score below min_score or zero are left out.
+///
+/// @return Returns false on success, true on error
+bool match_all_pairs(const state *s, int min_score, pair_table& t);
+
 /// Load the known hashes from the file fn and compare them to the
 /// set of known hashes
 bool match_compare_unknown(state *s, const char * fn);
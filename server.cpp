@@ -0,0 +1,374 @@
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// The server loads the known hashes once and then answers each query
+// with match_score(), which only reads the state. Every connection is
+// served by a thread of its own, and a client can send as many queries
+// as it likes over one connection.
+
+#include "server.h"
+#include "match.h"
+
+// Unix domain sockets aren't available on Windows
+#ifndef _WIN32
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#ifdef HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
+#define QUERY_SIG    "sig "
+#define QUERY_FILE   "file "
+#define ANSWER_ERROR "error: "
+
+// The longest query is a path with the word in front of it
+#define QUERY_MAX    (SSDEEP_PATH_MAX + 16)
+
+
+/// A connection to the server
+struct match_client
+{
+  FILE * in;
+  FILE * out;
+};
+
+
+static bool make_address(const char *path, struct sockaddr_un& addr)
+{
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path))
+  {
+    errno = ENAMETOOLONG;
+    return true;
+  }
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  return false;
+}
+
+
+// Open the two directions of the socket fd as streams. On error fd is
+// closed.
+static bool open_streams(int fd, FILE **in, FILE **out)
+{
+  *in = fdopen(fd, "r");
+  if (NULL == *in)
+  {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return true;
+  }
+
+  int out_fd = dup(fd);
+  *out = (out_fd < 0) ? NULL : fdopen(out_fd, "w");
+  if (NULL == *out)
+  {
+    int saved = errno;
+    if (out_fd >= 0)
+      close(out_fd);
+    fclose(*in);
+    errno = saved;
+    return true;
+  }
+
+  return false;
+}
+
+
+// ------------------------------------------------------------------
+// SERVER
+// ------------------------------------------------------------------
+
+// The socket to remove when we're told to stop
+static const char * server_path = NULL;
+
+static void server_stop(int)
+{
+  unlink(server_path);
+  _exit(EXIT_SUCCESS);
+}
+
+
+static void answer_sig(const state *s, const char *sig, FILE *out)
+{
+  Filedata * f;
+  try
+  {
+    f = new Filedata(std::string(sig), NULL);
+  }
+  catch (std::bad_alloc)
+  {
+    fprintf(out, "%sBad signature\n", ANSWER_ERROR);
+    return;
+  }
+
+  std::vector<std::pair<uint32_t,int> > scores;
+  match_score(s, f->get_digest(), scores);
+  match_write(out, s, f, scores);
+  delete f;
+}
+
+
+static void answer_file(const state *s, const char *fn, FILE *out)
+{
+  hash_result r;
+  int error = hash_file_result(s, fn, &r);
+  if (error)
+  {
+    fprintf(out, "%s%s: %s\n", ANSWER_ERROR, fn, strerror(error));
+    return;
+  }
+
+  Filedata * f;
+  try
+  {
+    f = new Filedata(fn, r.sum);
+  }
+  catch (std::bad_alloc)
+  {
+    fprintf(out, "%s%s: Unable to hash file\n", ANSWER_ERROR, fn);
+    return;
+  }
+
+  // The file has been scored already, as the knowns are fixed
+  if (r.scored)
+    match_write(out, s, f, r.scores);
+  delete f;
+}
+
+
+static void serve_connection(const state *s, int fd)
+{
+  FILE *in, *out;
+  if (open_streams(fd, &in, &out))
+    return;
+
+  char * query = (char *)malloc(QUERY_MAX);
+  while (NULL != query and NULL != fgets(query, QUERY_MAX, in))
+  {
+    size_t len = strlen(query);
+    if (len == QUERY_MAX - 1 and query[len - 1] != '\n')
+    {
+      fprintf(out, "%sQuery too long\n\n", ANSWER_ERROR);
+      break;
+    }
+    chop_line(query);
+
+    if (0 == strncmp(query, QUERY_SIG, strlen(QUERY_SIG)))
+      answer_sig(s, query + strlen(QUERY_SIG), out);
+    else if (0 == strncmp(query, QUERY_FILE, strlen(QUERY_FILE)))
+      answer_file(s, query + strlen(QUERY_FILE), out);
+    else
+      fprintf(out, "%sUnknown query\n", ANSWER_ERROR);
+
+    // An empty line ends each answer
+    fputc('\n', out);
+    if (fflush(out))
+      break;
+  }
+
+  free(query);
+  fclose(out);
+  fclose(in);
+}
+
+
+#ifdef HAVE_PTHREAD_H
+typedef struct
+{
+  const state * s;
+  int fd;
+} connection;
+
+
+static void * connection_thread(void *arg)
+{
+  connection * c = (connection *)arg;
+  serve_connection(c->s, c->fd);
+  delete c;
+  return NULL;
+}
+#endif
+
+
+// True if a server is already listening at addr
+static bool server_listening(const struct sockaddr_un& addr)
+{
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return false;
+  bool found = (0 == connect(fd, (const struct sockaddr *)&addr, sizeof(addr)));
+  close(fd);
+  return found;
+}
+
+
+bool server_run(const state *s, const char *path)
+{
+  if (NULL == s or NULL == path)
+    return true;
+
+  struct sockaddr_un addr;
+  if (make_address(path, addr))
+    return true;
+
+  // A socket left behind by a server which is no longer running is
+  // replaced. Anything else at path is left alone, and bind() fails.
+  struct stat sb;
+  if (0 == lstat(path, &sb) and S_ISSOCK(sb.st_mode))
+  {
+    if (server_listening(addr))
+    {
+      errno = EADDRINUSE;
+      return true;
+    }
+    unlink(path);
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return true;
+
+  // Path queries are hashed with our permissions, so only we may connect
+  mode_t mask = umask(077);
+  int status = bind(fd, (const struct sockaddr *)&addr, sizeof(addr));
+  umask(mask);
+  if (status or listen(fd, SOMAXCONN))
+  {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return true;
+  }
+
+  server_path = path;
+  signal(SIGINT, server_stop);
+  signal(SIGTERM, server_stop);
+  signal(SIGHUP, server_stop);
+  // Clients which go away are noticed when writing to them fails
+  signal(SIGPIPE, SIG_IGN);
+
+  for (;;)
+  {
+    int client = accept(fd, NULL, NULL);
+    if (client < 0)
+    {
+      if (EINTR == errno or ECONNABORTED == errno)
+	continue;
+      int saved = errno;
+      close(fd);
+      unlink(path);
+      errno = saved;
+      return true;
+    }
+
+#ifdef HAVE_PTHREAD_H
+    pthread_t thread;
+    connection * c = new connection;
+    c->s  = s;
+    c->fd = client;
+    if (0 == pthread_create(&thread, NULL, connection_thread, c))
+    {
+      pthread_detach(thread);
+      continue;
+    }
+    delete c;
+#endif
+    serve_connection(s, client);
+  }
+}
+
+
+// ------------------------------------------------------------------
+// CLIENT
+// ------------------------------------------------------------------
+
+bool client_connect(state *s, const char *path)
+{
+  if (NULL == s or NULL == path)
+    return true;
+
+  struct sockaddr_un addr;
+  if (make_address(path, addr))
+    return true;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return true;
+  if (connect(fd, (const struct sockaddr *)&addr, sizeof(addr)))
+  {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return true;
+  }
+
+  match_client * c = new match_client;
+  if (open_streams(fd, &c->in, &c->out))
+  {
+    delete c;
+    return true;
+  }
+
+  // A server which goes away is reported, rather than killing us
+  signal(SIGPIPE, SIG_IGN);
+  s->client = c;
+  return false;
+}
+
+
+bool client_query(state *s, const TCHAR *fn, const char *sum)
+{
+  if (NULL == s or NULL == s->client)
+    return true;
+
+  match_client * c = s->client;
+  fprintf(c->out, "%s%s,\"", QUERY_SIG, sum);
+  display_filename(c->out, fn, TRUE);
+  fprintf(c->out, "\"\n");
+  if (fflush(c->out))
+    return true;
+
+  // Answer lines can hold two filenames, so they are read a character
+  // at a time rather than into a buffer of fixed size
+  std::string line;
+  for (;;)
+  {
+    int ch = getc(c->in);
+    if (EOF == ch)
+    {
+      if (not ferror(c->in))
+	errno = ECONNRESET;
+      return true;
+    }
+    if (ch != '\n')
+    {
+      line += (char)ch;
+      continue;
+    }
+
+    if (line.empty())
+      return false;
+    if (0 == line.compare(0, strlen(ANSWER_ERROR), ANSWER_ERROR))
+      print_error(s, "%s: %s", __progname, line.c_str() + strlen(ANSWER_ERROR));
+    else
+      print_status("%s", line.c_str());
+    line.clear();
+  }
+}
+
+#endif   // ifndef _WIN32
@@ -0,0 +1,50 @@
+#ifndef __SERVER_H
+#define __SERVER_H
+
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+#include "ssdeep.h"
+
+// *********************************************************************
+// Match server and its clients, over a Unix domain socket. Neither is
+// available on Windows.
+//
+// Each query is one line, and each answer is the match lines for it
+// followed by an empty line. A query is either
+//
+//   sig [blocksize]:[sig1]:[sig2],"filename"
+//
+// as in a file of signatures, or
+//
+//   file [path]
+//
+// for a file which the server hashes itself. Errors are answered with
+// a line starting "error: ".
+// *********************************************************************
+
+/// @brief Answer queries about the set of known hashes on the socket
+/// path until the program is killed. The socket can only be used by the
+/// user running the server.
+///
+/// @return Returns true on error, otherwise doesn't return
+bool server_run(const state *s, const char *path);
+
+/// @brief Connect to the server on the socket path. Each file hashed
+/// after this is sent to the server instead of being displayed.
+///
+/// @return Returns false on success, true on error
+bool client_connect(state *s, const char *path);
+
+/// @brief Ask the server for the matches of the file fn, whose
+/// signature is sum, and display the answer.
+///
+/// @return Returns false on success, true on error
+bool client_query(state *s, const TCHAR *fn, const char *sum);
+
+#endif   // ifndef __SERVER_H
@@ -0,0 +1,622 @@
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// A database holds the same known hashes as a file of signatures, laid
+// out so it can be used straight from memory. See FILEFORMAT for the
+// layout. Every number is stored little endian. The 7-gram index is
+// used in place only where that is also the byte order of the machine;
+// elsewhere it is rebuilt from the signatures as they are loaded.
+
+#include "sigdb.h"
+#include "match.h"
+
+#include <algorithm>
+#include <vector>
+
+// Databases are mapped like any other file, but as there is no -M on
+// Windows there is nothing to load there either.
+#ifndef _WIN32
+
+#define SSDB_MAGIC         "SSDB"
+#define SSDB_MAGIC_LENGTH  4
+#define SSDB_VERSION       1
+
+// Flags in the header
+#define SSDB_FLAG_INDEX    1
+
+#define SSDB_HEADER_SIZE   64
+#define SSDB_GROUP_SIZE    32
+#define SSDB_RECORD_SIZE   (16 + 2 * SPAMSUM_LENGTH)
+#define SSDB_POSTING_SIZE  8
+
+// Fields of the header
+#define HDR_VERSION         4
+#define HDR_FLAGS           8
+#define HDR_GROUPS         12
+#define HDR_RECORDS        16
+#define HDR_RECORD_OFFSET  24
+#define HDR_STRING_OFFSET  32
+#define HDR_STRING_SIZE    40
+#define HDR_INDEX_OFFSET   48
+#define HDR_POSTINGS       56
+
+// Fields of a group, which holds the records for one blocksize
+#define GRP_BLOCK_SIZE      0
+#define GRP_FIRST_RECORD    8
+#define GRP_RECORDS        12
+#define GRP_FIRST_POSTING  16
+#define GRP_POSTINGS       24
+
+// Fields of a record, which holds one known hash
+#define REC_NAME_OFFSET     0
+#define REC_NAME_LENGTH     4
+#define REC_POSITION        8
+#define REC_LENGTH1        12
+#define REC_LENGTH2        13
+#define REC_PART1          16
+#define REC_PART2          (REC_PART1 + SPAMSUM_LENGTH)
+
+// Long enough for [blocksize]:[sig1]:[sig2] from a record
+#define SIG_BUFFER_SIZE    (2 * SPAMSUM_LENGTH + 24)
+
+
+static void put_le(unsigned char *p, uint64_t v, size_t bytes)
+{
+  for (size_t i = 0 ; i < bytes ; ++i)
+  {
+    p[i] = (unsigned char)(v & 0xff);
+    v >>= 8;
+  }
+}
+
+
+static uint64_t get_le(const unsigned char *p, size_t bytes)
+{
+  uint64_t v = 0;
+  while (bytes-- > 0)
+    v = (v << 8) | p[bytes];
+  return v;
+}
+
+
+static bool host_is_little_endian(void)
+{
+  const uint16_t one = 1;
+  return (1 == *(const unsigned char *)&one);
+}
+
+
+static uint64_t align8(uint64_t n)
+{
+  return (n + 7) & ~(uint64_t)7;
+}
+
+
+bool sigdb_is_database(const char *fn)
+{
+  char magic[SSDB_MAGIC_LENGTH];
+
+  // Reading from a pipe would lose what we read, and a database has to
+  // be mapped anyway
+  struct stat sb;
+  if (stat(fn, &sb) or not S_ISREG(sb.st_mode))
+    return false;
+
+  FILE * handle = fopen(fn, "rb");
+  if (NULL == handle)
+    return false;
+
+  bool found = (fread(magic, 1, sizeof(magic), handle) == sizeof(magic) and
+		0 == memcmp(magic, SSDB_MAGIC, sizeof(magic)));
+  fclose(handle);
+  return found;
+}
+
+
+// ------------------------------------------------------------------
+// WRITING
+// ------------------------------------------------------------------
+
+// Orders the positions of knowns by their blocksize
+struct by_block_size
+{
+  by_block_size(const state *s) : m_s(s) {}
+  bool operator()(uint32_t a, uint32_t b) const
+  {
+    return (m_s->all_files.get_block_size(a) <
+	    m_s->all_files.get_block_size(b));
+  }
+  const state * m_s;
+};
+
+
+typedef struct
+{
+  unsigned long block_size;
+  uint32_t first_record;
+  uint32_t records;
+  uint64_t first_posting;
+  uint64_t postings;
+} db_group;
+
+
+static bool write_bytes(FILE *handle, const void *p, size_t n)
+{
+  return (fwrite(p, 1, n, handle) != n);
+}
+
+
+static bool write_padding(FILE *handle, uint64_t from, uint64_t to)
+{
+  for ( ; from < to ; ++from)
+    if (EOF == putc(0, handle))
+      return true;
+  return false;
+}
+
+
+// Write the postings for the records of one group, sorted by key and
+// then by the position of the known
+static bool write_postings(FILE *handle,
+			   const state *s,
+			   const std::vector<uint32_t>& order,
+			   db_group& g)
+{
+  std::vector<std::pair<uint32_t,uint32_t> > postings;
+  std::vector<uint32_t> keys;
+  struct fuzzy_parsed_digest d;
+  for (uint32_t r = 0 ; r < g.records ; ++r)
+  {
+    uint32_t position = order[g.first_record + r];
+    s->all_files.get_digest(position, d);
+    SigIndex::keys(d, keys);
+    std::vector<uint32_t>::const_iterator it;
+    for (it = keys.begin() ; it != keys.end() ; ++it)
+      postings.push_back(std::make_pair(*it, position));
+  }
+  std::sort(postings.begin(), postings.end());
+
+  g.postings = postings.size();
+  unsigned char buffer[SSDB_POSTING_SIZE];
+  for (size_t i = 0 ; i < postings.size() ; ++i)
+  {
+    put_le(buffer, postings[i].first, 4);
+    put_le(buffer + 4, postings[i].second, 4);
+    if (write_bytes(handle, buffer, sizeof(buffer)))
+      return true;
+  }
+
+  return false;
+}
+
+
+static bool write_database(const state *s, FILE *handle, bool with_index)
+{
+  // The records are grouped by blocksize. Each remembers its position
+  // among the knowns, so they can be loaded in the order we have them.
+  std::vector<uint32_t> order;
+  uint32_t total = s->all_files.size();
+  for (uint32_t i = 0 ; i < total ; ++i)
+    order.push_back(i);
+  std::stable_sort(order.begin(), order.end(), by_block_size(s));
+  std::vector<db_group> groups;
+  for (uint32_t r = 0 ; r < order.size() ; ++r)
+  {
+    unsigned long block_size = s->all_files.get_block_size(order[r]);
+    if (groups.empty() or groups.back().block_size != block_size)
+    {
+      db_group g;
+      g.block_size    = block_size;
+      g.first_record  = r;
+      g.records       = 0;
+      g.first_posting = 0;
+      g.postings      = 0;
+      groups.push_back(g);
+    }
+    groups.back().records++;
+  }
+
+  // The header and groups are written once the index is done and we
+  // know how many postings each group has
+  uint64_t record_offset = SSDB_HEADER_SIZE +
+    (uint64_t)groups.size() * SSDB_GROUP_SIZE;
+  if (write_padding(handle, 0, record_offset))
+    return true;
+
+  unsigned char record[SSDB_RECORD_SIZE];
+  uint64_t name_offset = 0;
+  struct fuzzy_parsed_digest d;
+  for (uint32_t r = 0 ; r < order.size() ; ++r)
+  {
+    s->all_files.get_digest(order[r], d);
+    size_t name_length = strlen(s->all_files.get_filename(order[r]));
+    if (name_offset + name_length >= UINT32_MAX)
+    {
+      errno = EFBIG;
+      return true;
+    }
+
+    memset(record, 0, sizeof(record));
+    put_le(record + REC_NAME_OFFSET, name_offset, 4);
+    put_le(record + REC_NAME_LENGTH, name_length, 4);
+    put_le(record + REC_POSITION, order[r], 4);
+    record[REC_LENGTH1] = (unsigned char)d.len1;
+    record[REC_LENGTH2] = (unsigned char)d.len2;
+    memcpy(record + REC_PART1, d.digest1, kept_part_chars(d.len1));
+    memcpy(record + REC_PART2, d.digest2, kept_part_chars(d.len2));
+    if (write_bytes(handle, record, sizeof(record)))
+      return true;
+
+    name_offset += name_length + 1;
+  }
+
+  // Each filename is followed by a NUL
+  uint64_t string_offset = record_offset +
+    (uint64_t)order.size() * SSDB_RECORD_SIZE;
+  uint64_t string_size = name_offset;
+  for (uint32_t r = 0 ; r < order.size() ; ++r)
+  {
+    const char * name = s->all_files.get_filename(order[r]);
+    if (write_bytes(handle, name, strlen(name) + 1))
+      return true;
+  }
+
+  uint64_t index_offset = 0, postings = 0;
+  if (with_index)
+  {
+    index_offset = align8(string_offset + string_size);
+    if (write_padding(handle, string_offset + string_size, index_offset))
+      return true;
+
+    for (size_t i = 0 ; i < groups.size() ; ++i)
+    {
+      groups[i].first_posting = postings;
+      if (write_postings(handle, s, order, groups[i]))
+	return true;
+      postings += groups[i].postings;
+    }
+  }
+
+  unsigned char header[SSDB_HEADER_SIZE];
+  memset(header, 0, sizeof(header));
+  memcpy(header, SSDB_MAGIC, SSDB_MAGIC_LENGTH);
+  put_le(header + HDR_VERSION, SSDB_VERSION, 4);
+  put_le(header + HDR_FLAGS, with_index ? SSDB_FLAG_INDEX : 0, 4);
+  put_le(header + HDR_GROUPS, groups.size(), 4);
+  put_le(header + HDR_RECORDS, total, 4);
+  put_le(header + HDR_RECORD_OFFSET, record_offset, 8);
+  put_le(header + HDR_STRING_OFFSET, string_offset, 8);
+  put_le(header + HDR_STRING_SIZE, string_size, 8);
+  put_le(header + HDR_INDEX_OFFSET, index_offset, 8);
+  put_le(header + HDR_POSTINGS, postings, 8);
+
+  rewind(handle);
+  if (write_bytes(handle, header, sizeof(header)))
+    return true;
+
+  unsigned char group[SSDB_GROUP_SIZE];
+  for (size_t i = 0 ; i < groups.size() ; ++i)
+  {
+    put_le(group + GRP_BLOCK_SIZE, groups[i].block_size, 8);
+    put_le(group + GRP_FIRST_RECORD, groups[i].first_record, 4);
+    put_le(group + GRP_RECORDS, groups[i].records, 4);
+    put_le(group + GRP_FIRST_POSTING, groups[i].first_posting, 8);
+    put_le(group + GRP_POSTINGS, groups[i].postings, 8);
+    if (write_bytes(handle, group, sizeof(group)))
+      return true;
+  }
+
+  return false;
+}
+
+
+bool sigdb_write(const state *s, const char *fn, bool with_index)
+{
+  if (NULL == s or NULL == fn)
+    return true;
+
+  // Programs may have the old database mapped, so the new one is
+  // written next to it and then renamed over it.
+  std::string tmp_fn = std::string(fn) + ".XXXXXX";
+  std::vector<char> tmp_buf(tmp_fn.begin(), tmp_fn.end());
+  tmp_buf.push_back('\0');
+  int fd = mkstemp(&tmp_buf[0]);
+  if (fd < 0)
+    return true;
+
+  FILE * handle = fdopen(fd, "wb");
+  if (NULL == handle)
+  {
+    close(fd);
+    unlink(&tmp_buf[0]);
+    return true;
+  }
+
+  // mkstemp() makes a file only we can read, but a database is meant
+  // to be shared like any file of signatures
+  mode_t mask = umask(0);
+  umask(mask);
+
+  bool error = (write_database(s, handle, with_index) or
+		fflush(handle) != 0 or
+		fchmod(fd, 0666 & ~mask) != 0 or
+		fsync(fd) != 0);
+  if (fclose(handle) != 0)
+    error = true;
+  if (not error and rename(&tmp_buf[0], fn) != 0)
+    error = true;
+  if (error)
+  {
+    int saved = errno;
+    unlink(&tmp_buf[0]);
+    errno = saved;
+    return true;
+  }
+
+  return false;
+}
+
+
+// ------------------------------------------------------------------
+// LOADING
+// ------------------------------------------------------------------
+
+// Check the sections and groups lie within the database, so they can
+// be used without any further checks. The records are checked as they
+// are loaded.
+static bool valid_database(const unsigned char *db, uint64_t size)
+{
+  if (memcmp(db, SSDB_MAGIC, SSDB_MAGIC_LENGTH) or
+      get_le(db + HDR_VERSION, 4) != SSDB_VERSION)
+    return false;
+
+  uint64_t flags         = get_le(db + HDR_FLAGS, 4);
+  uint64_t groups        = get_le(db + HDR_GROUPS, 4);
+  uint64_t records       = get_le(db + HDR_RECORDS, 4);
+  uint64_t record_offset = get_le(db + HDR_RECORD_OFFSET, 8);
+  uint64_t string_offset = get_le(db + HDR_STRING_OFFSET, 8);
+  uint64_t string_size   = get_le(db + HDR_STRING_SIZE, 8);
+  uint64_t index_offset  = get_le(db + HDR_INDEX_OFFSET, 8);
+  uint64_t postings      = get_le(db + HDR_POSTINGS, 8);
+
+  if (groups > (size - SSDB_HEADER_SIZE) / SSDB_GROUP_SIZE or
+      record_offset > size or
+      records > (size - record_offset) / SSDB_RECORD_SIZE or
+      string_offset > size or
+      string_size > size - string_offset)
+    return false;
+
+  if ((flags & SSDB_FLAG_INDEX) and
+      (index_offset % 8 != 0 or
+       index_offset > size or
+       postings > (size - index_offset) / SSDB_POSTING_SIZE))
+    return false;
+
+  // The groups hold every record, in order
+  uint64_t next_record = 0;
+  for (uint64_t i = 0 ; i < groups ; ++i)
+  {
+    const unsigned char * g = db + SSDB_HEADER_SIZE + i * SSDB_GROUP_SIZE;
+    uint64_t first_posting = get_le(g + GRP_FIRST_POSTING, 8);
+    uint64_t count         = get_le(g + GRP_RECORDS, 4);
+    if (get_le(g + GRP_BLOCK_SIZE, 8) > ULONG_MAX or
+	get_le(g + GRP_FIRST_RECORD, 4) != next_record or
+	count > records - next_record)
+      return false;
+    next_record += count;
+
+    if ((flags & SSDB_FLAG_INDEX) and
+	(first_posting > postings or
+	 get_le(g + GRP_POSTINGS, 8) > postings - first_posting))
+      return false;
+  }
+
+  return (next_record == records);
+}
+
+
+// Check the records in the database. The record at each position among
+// the knowns and its group are stored in record_at, and the positions of
+// the records in each group in positions. Returns true if any record is
+// damaged.
+static bool check_records(const state *s,
+			  const char *fn,
+			  const unsigned char *db,
+			  std::vector<std::pair<uint32_t,uint32_t> >& record_at,
+			  std::vector<std::vector<uint32_t> >& positions)
+{
+  uint64_t groups        = get_le(db + HDR_GROUPS, 4);
+  uint64_t records       = get_le(db + HDR_RECORDS, 4);
+  uint64_t record_offset = get_le(db + HDR_RECORD_OFFSET, 8);
+  uint64_t string_size   = get_le(db + HDR_STRING_SIZE, 8);
+  const char * strings =
+    (const char *)db + get_le(db + HDR_STRING_OFFSET, 8);
+
+  record_at.assign(records, std::make_pair(UINT32_MAX, UINT32_MAX));
+  positions.resize(groups);
+
+  for (uint64_t i = 0 ; i < groups ; ++i)
+  {
+    const unsigned char * g = db + SSDB_HEADER_SIZE + i * SSDB_GROUP_SIZE;
+    uint64_t first = get_le(g + GRP_FIRST_RECORD, 4);
+    uint64_t count = get_le(g + GRP_RECORDS, 4);
+
+    for (uint64_t r = first ; r < first + count ; ++r)
+    {
+      const unsigned char * rec = db + record_offset + r * SSDB_RECORD_SIZE;
+      uint64_t name_offset = get_le(rec + REC_NAME_OFFSET, 4);
+      uint64_t name_length = get_le(rec + REC_NAME_LENGTH, 4);
+      uint64_t position    = get_le(rec + REC_POSITION, 4);
+      unsigned int len1 = rec[REC_LENGTH1];
+      unsigned int len2 = rec[REC_LENGTH2];
+
+      // The parts are stored as they were parsed, so neither can hold
+      // the character which ended it
+      if (position >= records or
+	  record_at[position].first != UINT32_MAX or
+	  len1 > SPAMSUM_LENGTH + 1 or
+	  len2 > SPAMSUM_LENGTH + 1 or
+	  NULL != memchr(rec + REC_PART1, ':', kept_part_chars(len1)) or
+	  NULL != memchr(rec + REC_PART2, ',', kept_part_chars(len2)) or
+	  name_offset >= string_size or
+	  name_length >= string_size - name_offset or
+	  strings[name_offset + name_length] != '\0')
+      {
+	print_error(s, "%s: Bad hash in record %llu",
+		    fn, (unsigned long long)r);
+	return true;
+      }
+
+      record_at[position] = std::make_pair((uint32_t)r, (uint32_t)i);
+      positions[i].push_back((uint32_t)position);
+    }
+  }
+
+  return false;
+}
+
+
+// Add the records in the database to the set of knowns in the order of
+// their positions, without indexing them
+static void add_records(state *s,
+			const char *fn,
+			const unsigned char *db,
+			const std::vector<std::pair<uint32_t,uint32_t> >& record_at)
+{
+  uint64_t record_offset = get_le(db + HDR_RECORD_OFFSET, 8);
+  const char * strings =
+    (const char *)db + get_le(db + HDR_STRING_OFFSET, 8);
+
+  s->all_files.reserve(record_at.size(),
+		       0,
+		       (size_t)get_le(db + HDR_STRING_SIZE, 8));
+
+  char sig[SIG_BUFFER_SIZE];
+  struct fuzzy_parsed_digest d;
+  for (size_t p = 0 ; p < record_at.size() ; ++p)
+  {
+    uint64_t r = record_at[p].first;
+    const unsigned char * g = 
+      db + SSDB_HEADER_SIZE + (uint64_t)record_at[p].second * SSDB_GROUP_SIZE;
+    const unsigned char * rec = db + record_offset + r * SSDB_RECORD_SIZE;
+
+    snprintf(sig, sizeof(sig), "%lu:%.*s:%.*s",
+	     (unsigned long)get_le(g + GRP_BLOCK_SIZE, 8),
+	     (int)kept_part_chars(rec[REC_LENGTH1]),
+	     (const char *)rec + REC_PART1,
+	     (int)kept_part_chars(rec[REC_LENGTH2]),
+	     (const char *)rec + REC_PART2);
+    // check_records() made sure this works
+    if (fuzzy_parse_digest(&d, sig))
+      internal_error("%s: Unable to parse record %llu", 
+		     fn, (unsigned long long)r);
+    // Parts which were too long still can't match anything
+    d.len1 = rec[REC_LENGTH1];
+    d.len2 = rec[REC_LENGTH2];
+
+    s->all_files.add(d, strings + get_le(rec + REC_NAME_OFFSET, 4), fn);
+  }
+}
+
+
+bool sigdb_load(state *s, const char *fn)
+{
+  if (NULL == s or NULL == fn)
+    return true;
+
+  int fd = open(fn, O_RDONLY);
+  if (fd < 0)
+  {
+    if ( ! (MODE(mode_silent)) )
+      perror(fn);
+    return true;
+  }
+
+  struct stat sb;
+  if (fstat(fd, &sb))
+  {
+    if ( ! (MODE(mode_silent)) )
+      perror(fn);
+    close(fd);
+    return true;
+  }
+  if (sb.st_size < SSDB_HEADER_SIZE or (uint64_t)sb.st_size > SIZE_MAX)
+  {
+    print_error(s, "%s: Invalid database.", fn);
+    close(fd);
+    return true;
+  }
+
+  size_t size = (size_t)sb.st_size;
+  bool mapped;
+  const unsigned char * db = map_file(fd, size, mapped);
+  close(fd);
+  if (NULL == db)
+  {
+    if ( ! (MODE(mode_silent)) )
+      perror(fn);
+    return true;
+  }
+
+  uint32_t base = s->all_files.size();
+  if (not valid_database(db, size) or
+      get_le(db + HDR_RECORDS, 4) > UINT32_MAX - base)
+  {
+    print_error(s, "%s: Invalid database.", fn);
+    unmap_file(db, size, mapped);
+    return true;
+  }
+
+  std::vector<std::pair<uint32_t,uint32_t> > record_at;
+  std::vector<std::vector<uint32_t> > positions;
+  if (check_records(s, fn, db, record_at, positions))
+  {
+    unmap_file(db, size, mapped);
+    return true;
+  }
+  add_records(s, fn, db, record_at);
+
+  // Without an index we can use, the knowns are indexed as they would
+  // be from a file of signatures
+  if (not (get_le(db + HDR_FLAGS, 4) & SSDB_FLAG_INDEX) or
+      not host_is_little_endian())
+  {
+    struct fuzzy_parsed_digest d;
+    for (uint32_t i = base ; i < s->all_files.size() ; ++i)
+    {
+      s->all_files.get_digest(i, d);
+      s->known_index.insert(i, d);
+    }
+    unmap_file(db, size, mapped);
+    return false;
+  }
+
+  // The index is used where it is, so the database is never released
+  const SigIndex::mapped_posting * postings =
+    (const SigIndex::mapped_posting *)(db + get_le(db + HDR_INDEX_OFFSET, 8));
+  uint64_t groups = get_le(db + HDR_GROUPS, 4);
+  for (uint64_t i = 0 ; i < groups ; ++i)
+  {
+    const unsigned char * g = db + SSDB_HEADER_SIZE + i * SSDB_GROUP_SIZE;
+    s->known_index.insert_mapped((unsigned long)get_le(g + GRP_BLOCK_SIZE, 8),
+				 base,
+				 (uint32_t)record_at.size(),
+				 positions[i],
+				 postings + get_le(g + GRP_FIRST_POSTING, 8),
+				 (size_t)get_le(g + GRP_POSTINGS, 8));
+  }
+
+  return false;
+}
+
+#endif   // ifndef _WIN32
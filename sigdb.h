@@ -0,0 +1,46 @@
+#ifndef __SIGDB_H
+#define __SIGDB_H
+
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+#include "ssdeep.h"
+
+// *********************************************************************
+// Binary databases of known hashes. The format is described in
+// FILEFORMAT. Databases are not available on Windows.
+// *********************************************************************
+
+/// @brief Determine if fn is a database of known hashes rather than a
+/// file of signatures
+///
+/// @return Returns true if the file starts with the database magic
+bool sigdb_is_database(const char *fn);
+
+/// @brief Write the set of known hashes to fn as a database
+///
+/// The new database replaces any existing file in one step, so programs
+/// using the old one are not disturbed.
+///
+/// @param s State variable
+/// @param fn Name of the database to write
+/// @param with_index Whether to include the 7-gram index of the knowns
+///
+/// @return Returns false on success, true on error
+bool sigdb_write(const state *s, const char *fn, bool with_index);
+
+/// @brief Add the known hashes in the database fn to the set of knowns
+///
+/// The database is mapped into memory. If it has an index, the index is
+/// used where it is, and the mapping is kept for as long as the program
+/// runs.
+///
+/// @return Returns false on success, true on error
+bool sigdb_load(state *s, const char *fn);
+
+#endif   // ifndef __SIGDB_H
@@ -0,0 +1,259 @@
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "sigindex.h"
+
+#include <algorithm>
+#include <limits.h>
+
+// Must match ROLLING_WINDOW in fuzzy.c
+#define GRAM_LENGTH  7
+
+// Which part of a known signature a 7-gram came from. Signatures where
+// neither part is long enough to contain a 7-gram are filed once under
+// PART_NONE, since they can still score 100 against an identical one.
+#define PART_NONE    0
+#define PART_FIRST   1
+#define PART_SECOND  2
+
+#define INVALID_POSTING  UINT32_MAX
+
+
+static uint32_t make_key(unsigned int part, uint64_t gram)
+{
+  // 64-bit finalizer from MurmurHash3
+  uint64_t h = gram ^ ((uint64_t)part << 56);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return (uint32_t)h;
+}
+
+
+// Compute the keys for every 7-gram of s as the given part.
+static void gram_keys(unsigned int part,
+		      const char *s,
+		      size_t len,
+		      std::vector<uint32_t>& keys)
+{
+  // A part which was too long can't match anything
+  if (len < GRAM_LENGTH or len > SPAMSUM_LENGTH)
+    return;
+
+  uint64_t gram = 0;
+  for (size_t i = 0 ; i < len ; ++i)
+  {
+    gram = ((gram << 8) | (unsigned char)s[i]) & 0xffffffffffffffULL;
+    if (i >= GRAM_LENGTH - 1)
+      keys.push_back(make_key(part, gram));
+  }
+}
+
+
+static void sort_unique(std::vector<uint32_t>& v)
+{
+  std::sort(v.begin(), v.end());
+  v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+
+void SigIndex::bucket::grow(void)
+{
+  size_t buckets = heads.empty() ? 256 : heads.size() * 2;
+  heads.assign(buckets, INVALID_POSTING);
+  mask = (uint32_t)(buckets - 1);
+
+  // Rethread the existing postings through the larger table. Walking
+  // them in insertion order keeps each chain newest-first.
+  for (size_t i = 0 ; i < postings.size() ; ++i)
+  {
+    uint32_t b = postings[i].key & mask;
+    postings[i].next = heads[b];
+    heads[b] = (uint32_t)i;
+  }
+}
+
+
+void SigIndex::bucket::add(uint32_t key, uint32_t id)
+{
+  if (postings.size() >= heads.size())
+    grow();
+
+  uint32_t b = key & mask;
+  posting p;
+  p.key  = key;
+  p.id   = id;
+  p.next = heads[b];
+  heads[b] = (uint32_t)postings.size();
+  postings.push_back(p);
+}
+
+
+// Orders mapped postings by key alone, for searching
+static bool posting_before(const SigIndex::mapped_posting& p, uint32_t key)
+{
+  return p.key < key;
+}
+
+
+void SigIndex::bucket::lookup(uint32_t key, std::vector<uint32_t>& ids) const
+{
+  std::vector<mapped_run>::const_iterator r;
+  for (r = runs.begin() ; r != runs.end() ; ++r)
+  {
+    const mapped_posting *p = std::lower_bound(r->postings,
+					       r->postings + r->n,
+					       key,
+					       posting_before);
+    for ( ; p != r->postings + r->n and p->key == key ; ++p)
+      if (p->id < r->limit)
+	ids.push_back(r->base + p->id);
+  }
+
+  if (heads.empty())
+    return;
+
+  uint32_t i = heads[key & mask];
+  while (i != INVALID_POSTING)
+  {
+    const posting& p = postings[i];
+    if (p.key == key)
+      ids.push_back(p.id);
+    i = p.next;
+  }
+}
+
+
+const SigIndex::bucket * SigIndex::find_bucket(unsigned long block_size) const
+{
+  std::map<unsigned long, bucket>::const_iterator it = m_buckets.find(block_size);
+  if (it == m_buckets.end())
+    return NULL;
+  return &(it->second);
+}
+
+
+void SigIndex::keys(const struct fuzzy_parsed_digest& d,
+		    std::vector<uint32_t>& keys)
+{
+  keys.clear();
+  gram_keys(PART_FIRST, d.digest1, d.len1, keys);
+  gram_keys(PART_SECOND, d.digest2, d.len2, keys);
+  if (keys.empty())
+    keys.push_back(make_key(PART_NONE, 0));
+  sort_unique(keys);
+}
+
+
+void SigIndex::insert(uint32_t id, const struct fuzzy_parsed_digest& d)
+{
+  std::vector<uint32_t> keys;
+  SigIndex::keys(d, keys);
+
+  bucket& b = m_buckets[d.block_size];
+  b.ids.push_back(id);
+  std::vector<uint32_t>::const_iterator it;
+  for (it = keys.begin() ; it != keys.end() ; ++it)
+    b.add(*it, id);
+}
+
+
+void SigIndex::insert_mapped(unsigned long block_size,
+			     uint32_t base,
+			     uint32_t limit,
+			     const std::vector<uint32_t>& positions,
+			     const mapped_posting *postings,
+			     size_t n)
+{
+  bucket& b = m_buckets[block_size];
+  std::vector<uint32_t>::const_iterator it;
+  for (it = positions.begin() ; it != positions.end() ; ++it)
+    b.ids.push_back(base + *it);
+
+  mapped_run r;
+  r.postings = postings;
+  r.n        = n;
+  r.base     = base;
+  r.limit    = limit;
+  b.runs.push_back(r);
+}
+
+
+void SigIndex::candidates(const struct fuzzy_parsed_digest& d,
+			  std::vector<uint32_t>& ids) const
+{
+  ids.clear();
+
+  std::vector<uint32_t> keys;
+  std::vector<uint32_t>::const_iterator it;
+  const bucket *b;
+
+  // Same blocksize: both parts line up
+  if ((b = find_bucket(d.block_size)) != NULL)
+  {
+    keys.clear();
+    gram_keys(PART_FIRST, d.digest1, d.len1, keys);
+    gram_keys(PART_SECOND, d.digest2, d.len2, keys);
+    if (keys.empty())
+      keys.push_back(make_key(PART_NONE, 0));
+    for (it = keys.begin() ; it != keys.end() ; ++it)
+      b->lookup(*it, ids);
+  }
+
+  // Double blocksize: our second part against their first
+  if (d.block_size <= ULONG_MAX / 2 and
+      (b = find_bucket(d.block_size * 2)) != NULL)
+  {
+    keys.clear();
+    gram_keys(PART_FIRST, d.digest2, d.len2, keys);
+    for (it = keys.begin() ; it != keys.end() ; ++it)
+      b->lookup(*it, ids);
+  }
+
+  // Half blocksize: our first part against their second
+  if (d.block_size % 2 == 0 and
+      (b = find_bucket(d.block_size / 2)) != NULL)
+  {
+    keys.clear();
+    gram_keys(PART_SECOND, d.digest1, d.len1, keys);
+    for (it = keys.begin() ; it != keys.end() ; ++it)
+      b->lookup(*it, ids);
+  }
+
+  sort_unique(ids);
+}
+
+
+void SigIndex::comparable(const struct fuzzy_parsed_digest& d,
+			  std::vector<uint32_t>& ids) const
+{
+  ids.clear();
+
+  const bucket *b;
+  if ((b = find_bucket(d.block_size)) != NULL)
+    ids.insert(ids.end(), b->ids.begin(), b->ids.end());
+  if (d.block_size <= ULONG_MAX / 2 and
+      (b = find_bucket(d.block_size * 2)) != NULL)
+    ids.insert(ids.end(), b->ids.begin(), b->ids.end());
+  if (d.block_size % 2 == 0 and
+      (b = find_bucket(d.block_size / 2)) != NULL)
+    ids.insert(ids.end(), b->ids.begin(), b->ids.end());
+
+  sort_unique(ids);
+}
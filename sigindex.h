@@ -0,0 +1,116 @@
+#ifndef __SIGINDEX_H
+#define __SIGINDEX_H
+
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+#include "fuzzy.h"
+
+/// @brief Store of the known signatures, partitioned by blocksize and
+/// indexed by the ROLLING_WINDOW length substrings (7-grams) of each part.
+///
+/// fuzzy_compare() returns zero unless the two blocksizes are equal, double
+/// or half, and only scores a pair of signature parts if they share a 7-gram.
+/// A query therefore only has to look at the buckets for bs/2, bs and 2*bs,
+/// and within those only at the knowns filed under one of its 7-grams.
+///
+/// Keys are hashed down to 32 bits and the postings are kept in flat
+/// chained tables. A hash collision only produces an extra candidate,
+/// never a missed one, so the caller must still run fuzzy_compare().
+class SigIndex
+{
+ public:
+  /// A 7-gram key of a known, as stored in a database of known hashes.
+  /// The id is the position of the known within the database.
+  struct mapped_posting
+  {
+    uint32_t key;
+    uint32_t id;
+  };
+
+  /// @brief Compute the keys a parsed signature is filed under. They
+  /// are stored in ascending order and without duplicates.
+  static void keys(const struct fuzzy_parsed_digest& d,
+		   std::vector<uint32_t>& keys);
+
+  /// @brief Add a parsed known signature under the given id. Ids should
+  /// be the position in the vector of knowns.
+  void insert(uint32_t id, const struct fuzzy_parsed_digest& d);
+
+  /// @brief Add the knowns of one blocksize from a database, using
+  /// postings computed ahead of time.
+  ///
+  /// The knowns are given by their positions in the database, and each
+  /// is added under base plus its position. The postings must be sorted
+  /// by key and then by id. They are used where they are rather than
+  /// copied, so they must outlive the index. Postings with an id of
+  /// limit or more are ignored.
+  void insert_mapped(unsigned long block_size,
+		     uint32_t base,
+		     uint32_t limit,
+		     const std::vector<uint32_t>& positions,
+		     const mapped_posting *postings,
+		     size_t n);
+
+  /// @brief Find every known which shares a 7-gram with d at a
+  /// comparable blocksize.
+  ///
+  /// The ids are stored in ascending order and without duplicates.
+  void candidates(const struct fuzzy_parsed_digest& d,
+		  std::vector<uint32_t>& ids) const;
+
+  /// @brief Find every known whose blocksize can be compared with d.
+  ///
+  /// Any known not returned here scores zero against d. The ids are
+  /// stored in ascending order and without duplicates.
+  void comparable(const struct fuzzy_parsed_digest& d,
+		  std::vector<uint32_t>& ids) const;
+
+ private:
+  struct posting
+  {
+    uint32_t key;
+    uint32_t id;
+    uint32_t next;
+  };
+
+  /// Knowns added with insert_mapped()
+  struct mapped_run
+  {
+    const mapped_posting *postings;
+    size_t n;
+    uint32_t base;
+    uint32_t limit;
+  };
+
+  /// All of the knowns with one blocksize
+  struct bucket
+  {
+    bucket() : mask(0) {}
+
+    void add(uint32_t key, uint32_t id);
+    void grow(void);
+    void lookup(uint32_t key, std::vector<uint32_t>& ids) const;
+
+    /// Members in the order they were added
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> heads;
+    std::vector<posting> postings;
+    uint32_t mask;
+    std::vector<mapped_run> runs;
+  };
+
+  const bucket * find_bucket(unsigned long block_size) const;
+
+  std::map<unsigned long, bucket> m_buckets;
+};
+
+#endif   // ifndef __SIGINDEX_H
@@ -0,0 +1,306 @@
+// SSDEEP
+// $Id$
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Loads a file of signatures by bringing the whole of it into memory and
+// cutting it into chunks at line boundaries, which are parsed by threads
+// of their own. Each line is parsed where it lies, and nothing is
+// allocated for it. The first chunk goes straight into the set of knowns
+// and the others into stores of their own, which are appended in order
+// once every chunk is done. Bad lines are reported after that, also in
+// order, so the result is the same as reading the file a line at a time.
+
+#include "match.h"
+
+#include <algorithm>
+
+#ifdef HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
+// Windows reads files of signatures a line at a time
+#ifndef _WIN32
+
+// The longest signature, without its filename, which we accept. Lines
+// read one at a time can't be any longer than this either.
+#define MAX_SIG_LENGTH   2048
+
+// Chunks smaller than this aren't worth a thread of their own
+#define MIN_CHUNK_SIZE   (1024 * 1024)
+
+#define NO_FILENAME      "[NO FILENAME]"
+
+
+typedef struct
+{
+  const char * start;
+  const char * stop;
+  const char * match_file;
+
+  /// Where the knowns in this chunk are added
+  KnownStore * knowns;
+  KnownStore   own;
+
+  /// Number of lines in the chunk
+  uint64_t lines;
+  /// The bad lines, counting from zero at the start of the chunk
+  std::vector<uint64_t> bad;
+} sig_chunk;
+
+
+// Parse the line from line to end, without its newline, and add it to
+// knowns. This accepts the same lines Filedata does. The name is
+// unescaped into name, whose memory is used again for each line.
+// Returns true if the line is bad.
+static bool parse_line(const char *line,
+		       const char *end,
+		       const char *match_file,
+		       KnownStore& knowns,
+		       std::vector<char>& name)
+{
+  // The newline may have come from DOS
+  while (end > line and '\r' == end[-1])
+    --end;
+
+  // Blank lines are skipped without an error
+  if (line == end)
+    return false;
+
+  // The signature ends at the comma before the filename, if any
+  const char * sig_end = line;
+  while (sig_end < end and ',' != *sig_end and '"' != *sig_end)
+    ++sig_end;
+
+  char sig[MAX_SIG_LENGTH];
+  size_t sig_length = (size_t)(sig_end - line);
+  if (sig_length >= sizeof(sig))
+    return true;
+  memcpy(sig, line, sig_length);
+  sig[sig_length] = '\0';
+
+  struct fuzzy_parsed_digest d;
+  if (fuzzy_parse_digest_lenient(&d, sig))
+    return true;
+
+  if (sig_end == end)
+  {
+    knowns.add(d, NO_FILENAME, match_file);
+    return false;
+  }
+
+  // The filename follows the comma and a quotation mark, and the line
+  // ends with another quotation mark
+  const char * fn = sig_end + 2;
+  if (fn > end or '"' != end[-1])
+    return true;
+
+  // Any backslashes in front of a quotation mark escape it
+  name.clear();
+  for ( ; fn < end - 1 ; ++fn)
+  {
+    if ('"' == *fn)
+      while (not name.empty() and '\\' == name.back())
+	name.pop_back();
+    name.push_back(*fn);
+  }
+  name.push_back('\0');
+
+  knowns.add(d, &name[0], match_file);
+  return false;
+}
+
+
+static void * parse_chunk(void *arg)
+{
+  sig_chunk * c = (sig_chunk *)arg;
+  std::vector<char> name;
+
+  const char * line = c->start;
+  while (line < c->stop)
+  {
+    const char * end = (const char *)memchr(line, '\n', c->stop - line);
+    if (NULL == end)
+      end = c->stop;
+
+    if (parse_line(line, end, c->match_file, *c->knowns, name))
+      c->bad.push_back(c->lines);
+    c->lines++;
+
+    line = end + 1;
+  }
+
+  return NULL;
+}
+
+
+// True if the line from start to end is a valid ssdeep header
+static bool is_header(const char *start, const char *end)
+{
+  while (end > start and ('\n' == end[-1] or '\r' == end[-1]))
+    --end;
+
+  size_t length = (size_t)(end - start);
+  return ((length == strlen(SSDEEPV1_0_HEADER) and
+	   0 == memcmp(start, SSDEEPV1_0_HEADER, length)) or
+	  (length == strlen(SSDEEPV1_1_HEADER) and
+	   0 == memcmp(start, SSDEEPV1_1_HEADER, length)));
+}
+
+
+// Returns the start of the line after the one p is in, or stop
+static const char * next_line(const char *p, const char *stop)
+{
+  const char * end = (const char *)memchr(p, '\n', stop - p);
+  return (NULL == end) ? stop : end + 1;
+}
+
+
+// Cut the lines from start to stop into chunks, at most one for each
+// thread
+static void make_chunks(const state *s,
+			const char *fn,
+			const char *start,
+			const char *stop,
+			std::vector<sig_chunk>& chunks)
+{
+  size_t size = (size_t)(stop - start);
+  size_t count = std::max(1u, s->threads);
+  count = std::min(count, size / MIN_CHUNK_SIZE + 1);
+
+  chunks.resize(count);
+  for (size_t i = 0 ; i < count ; ++i)
+  {
+    sig_chunk& c = chunks[i];
+    c.start = (0 == i) ? start : chunks[i - 1].stop;
+    if (i + 1 == count)
+      c.stop = stop;
+    else
+    {
+      // The chunk ends with the line which crosses its share of the file
+      const char * share = start + size / count * (i + 1);
+      c.stop = (share <= c.start) ? c.start : next_line(share - 1, stop);
+    }
+
+    c.match_file = fn;
+    c.lines = 0;
+  }
+}
+
+
+bool sig_file_load(state *s, const char *fn)
+{
+  if (NULL == s or NULL == fn)
+    return true;
+
+  int fd = open(fn, O_RDONLY);
+  if (fd < 0)
+  {
+    if ( ! (MODE(mode_silent)) )
+      perror(fn);
+    return true;
+  }
+
+  struct stat sb;
+  if (fstat(fd, &sb) or (uint64_t)sb.st_size > SIZE_MAX)
+  {
+    if ( ! (MODE(mode_silent)) )
+      perror(fn);
+    close(fd);
+    return true;
+  }
+
+  size_t size = (size_t)sb.st_size;
+  bool mapped;
+  const unsigned char * contents = map_file(fd, size, mapped);
+  close(fd);
+  if (NULL == contents)
+  {
+    if ( ! (MODE(mode_silent)) )
+      perror(fn);
+    return true;
+  }
+
+  // The first line of the file should contain a valid ssdeep header
+  const char * start = (const char *)contents;
+  const char * stop  = start + size;
+  const char * body  = next_line(start, stop);
+  if (not is_header(start, body))
+  {
+    print_error(s,"%s: Invalid file header.", fn);
+    unmap_file(contents, size, mapped);
+    return true;
+  }
+
+  uint32_t base = s->all_files.size();
+  std::vector<sig_chunk> chunks;
+  make_chunks(s, fn, body, stop, chunks);
+  chunks[0].knowns = &s->all_files;
+  for (size_t i = 1 ; i < chunks.size() ; ++i)
+    chunks[i].knowns = &chunks[i].own;
+
+#ifdef HAVE_PTHREAD_H
+  // The calling thread parses the first chunk, and any others whose
+  // thread couldn't be started
+  std::vector<pthread_t> threads(chunks.size());
+  std::vector<bool> started(chunks.size(), false);
+  for (size_t i = 1 ; i < chunks.size() ; ++i)
+    started[i] = (0 == pthread_create(&threads[i], NULL,
+				      parse_chunk, &chunks[i]));
+  for (size_t i = 0 ; i < chunks.size() ; ++i)
+    if (not started[i])
+      parse_chunk(&chunks[i]);
+  for (size_t i = 1 ; i < chunks.size() ; ++i)
+    if (started[i])
+      pthread_join(threads[i], NULL);
+#else
+  for (size_t i = 0 ; i < chunks.size() ; ++i)
+    parse_chunk(&chunks[i]);
+#endif
+
+  unmap_file(contents, size, mapped);
+
+  // The header is line one
+  uint64_t line_number = 2;
+  size_t count = 0, part_chars = 0, name_chars = 0;
+  for (size_t i = 0 ; i < chunks.size() ; ++i)
+  {
+    std::vector<uint64_t>::const_iterator it;
+    for (it = chunks[i].bad.begin() ; it != chunks[i].bad.end() ; ++it)
+      print_error(s,
+		  "%s: Bad hash in line %llu",
+		  fn,
+		  (unsigned long long)(line_number + *it));
+    line_number += chunks[i].lines;
+
+    count      += chunks[i].own.size();
+    part_chars += chunks[i].own.part_chars();
+    name_chars += chunks[i].own.name_chars();
+  }
+
+  s->all_files.reserve(count, part_chars, name_chars);
+  for (size_t i = 1 ; i < chunks.size() ; ++i)
+  {
+    s->all_files.append(chunks[i].own);
+    chunks[i].own = KnownStore();
+  }
+
+  struct fuzzy_parsed_digest d;
+  for (uint32_t i = base ; i < s->all_files.size() ; ++i)
+  {
+    s->all_files.get_digest(i, d);
+    s->known_index.insert(i, d);
+  }
+
+  return false;
+}
+
+#endif   // ifndef _WIN32
@@ -19,6 +19,9 @@
 #include "fuzzy.h"
 #include "tchar-local.h"
 #include "filedata.h"
+#include "knownstore.h"
+#include "sigindex.h"
+#include "cache.h"
 
 // This is a kludge, but it works.
 #define __progname "ssdeep"
@@ -34,6 +37,9 @@
 // this limit to 32,767 characters by prepending filenames with "\\?\"
 #define SSDEEP_PATH_MAX 32767
 
+// The most threads the -j flag may ask for
+#define SSDEEP_MAX_THREADS   256
+
 #define MD5DEEP_ALLOC(TYPE,VAR,SIZE)     \
 VAR = (TYPE *)malloc(sizeof(TYPE) * SIZE);  \
 if (NULL == VAR)  \
@@ -78,20 +84,54 @@ typedef struct _filedata_t
 } filedata_t;
 
 
+/// Work shared with the threads walking directories
+struct walk_state;
+
+/// Connection to a match server
+struct match_client;
+
+/// A file taking part in a match. That's either the known with the index
+/// known, when f is NULL, or the file f which isn't one of the knowns.
+typedef struct {
+  Filedata * f;
+  uint32_t   known;
+} file_ref;
+
 typedef struct {
   uint64_t  mode;
 
   bool       first_file_processed;
 
   // Known hashes
-  std::vector<Filedata *> all_files;
+  KnownStore all_files;
 
-  // Known clusters
-  std::set< std::set<Filedata *> * > all_clusters;
+  /// The entries of all_files by blocksize and 7-gram, used to skip
+  /// knowns which cannot match
+  SigIndex known_index;
+
+  // Known clusters, as disjoint sets of nodes. Each node is a file which
+  // has matched something, and the root of each tree is its cluster.
+  std::vector<file_ref>   cluster_files;
+  std::vector<uint32_t>   cluster_parent;
+  std::vector<uint8_t>    cluster_rank;
 
   /// Display files who score above the threshold
   uint8_t   threshold;
 
+  /// Number of threads to use when comparing the knowns to each other
+  unsigned int threads;
+  /// Directory mode matches are displayed once all files are hashed
+  bool      deferred_directory;
+
+  /// Directory walk in progress when using several threads
+  struct walk_state * walker;
+
+  /// Signatures kept from earlier runs, or NULL
+  HashCache * cache;
+
+  /// Server which does the matching for us, or NULL
+  struct match_client * client;
+
   bool       found_meaningful_file;
   bool       processed_file;
 
@@ -177,12 +217,48 @@ bool process_win32(state *s, TCHAR *fn);
 int process_normal(state *s, TCHAR *fn);
 int process_stdin(state *s);
 
+/// Process fn like process_normal(), but using s->threads threads to
+/// walk any directories. The results are displayed by
+/// process_parallel_done(), in the same order process_normal() would
+/// have displayed them.
+int process_parallel(state *s, TCHAR *fn);
+void process_parallel_done(state *s);
+
 
 // *********************************************************************
 // Fuzzy Hashing Engine
 // *********************************************************************
+/// What hashing a single file found, before anything is displayed
+typedef struct
+{
+  char sum[FUZZY_MAX_RESULT];
+  /// True if the file is bigger than SSDEEP_MIN_FILE_SIZE
+  bool meaningful;
+  /// True if the file has already been compared to the knowns
+  bool scored;
+  /// The knowns worth displaying and their scores, if scored
+  std::vector<std::pair<uint32_t,int> > scores;
+} hash_result;
+
 int hash_file(state *s, TCHAR *fn);
-bool display_result(state *s, const TCHAR * fn, const char * sum);
+
+/// @brief Hash the file fn and, when matching it against a fixed set of
+/// knowns, score it against them. Nothing is displayed and s is only
+/// read, so this can run on several threads at once.
+///
+/// @return Returns zero on success or the errno of the error
+int hash_file_result(const state *s, const TCHAR *fn, hash_result *r);
+
+/// Display the result of hash_file_result() as hash_file() would have
+bool display_hash_result(state *s, TCHAR *fn, const hash_result *r);
+
+/// Show which file is being hashed, in verbose mode
+void display_hashing_status(state *s, const TCHAR *fn);
+
+bool display_result(state *s, 
+		    const TCHAR * fn, 
+		    const char * sum,
+		    const hash_result * r = NULL);
 
 
 // *********************************************************************
@@ -217,6 +293,18 @@ int remove_escaped_quotes(char * str);
 
 void prepare_filename(state *s, TCHAR *fn);
 
+#ifndef _WIN32
+/// @brief Bring the first size bytes of fd into memory, mapping them
+/// where we can and reading them otherwise. mapped records which was
+/// done, for unmap_file().
+///
+/// @return Returns the contents of the file, or NULL on error
+const unsigned char * map_file(int fd, size_t size, bool& mapped);
+
+/// Release what map_file() returned
+void unmap_file(const unsigned char *p, size_t size, bool mapped);
+#endif
+
 // Returns the size of the given file, in bytes.
 
 #ifdef __cplusplus
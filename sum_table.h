@@ -0,0 +1,674 @@
+#ifndef SUM_TABLE_H
+#define SUM_TABLE_H
+
+/*
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Only the lowest six bits of the FNV hashes in fuzzy.c ever make it
+ * into a signature, as an index into the base64 alphabet. Multiplying
+ * and xoring never carry anything from the high bits down to the low
+ * ones, so those six bits depend only on the six low bits of the old
+ * hash and of the input character. This table holds the result for
+ * every combination:
+ *
+ *   sum_table[c][h] == ((h * HASH_PRIME) ^ c) % 64
+ *
+ * It is indexed by the character first so that updating several hashes
+ * with the same character reads from a single row.
+ */
+static const unsigned char sum_table[64][64] = {
+  {
+    0x00, 0x13, 0x26, 0x39, 0x0c, 0x1f, 0x32, 0x05,
+    0x18, 0x2b, 0x3e, 0x11, 0x24, 0x37, 0x0a, 0x1d,
+    0x30, 0x03, 0x16, 0x29, 0x3c, 0x0f, 0x22, 0x35,
+    0x08, 0x1b, 0x2e, 0x01, 0x14, 0x27, 0x3a, 0x0d,
+    0x20, 0x33, 0x06, 0x19, 0x2c, 0x3f, 0x12, 0x25,
+    0x38, 0x0b, 0x1e, 0x31, 0x04, 0x17, 0x2a, 0x3d,
+    0x10, 0x23, 0x36, 0x09, 0x1c, 0x2f, 0x02, 0x15,
+    0x28, 0x3b, 0x0e, 0x21, 0x34, 0x07, 0x1a, 0x2d
+  },
+  {
+    0x01, 0x12, 0x27, 0x38, 0x0d, 0x1e, 0x33, 0x04,
+    0x19, 0x2a, 0x3f, 0x10, 0x25, 0x36, 0x0b, 0x1c,
+    0x31, 0x02, 0x17, 0x28, 0x3d, 0x0e, 0x23, 0x34,
+    0x09, 0x1a, 0x2f, 0x00, 0x15, 0x26, 0x3b, 0x0c,
+    0x21, 0x32, 0x07, 0x18, 0x2d, 0x3e, 0x13, 0x24,
+    0x39, 0x0a, 0x1f, 0x30, 0x05, 0x16, 0x2b, 0x3c,
+    0x11, 0x22, 0x37, 0x08, 0x1d, 0x2e, 0x03, 0x14,
+    0x29, 0x3a, 0x0f, 0x20, 0x35, 0x06, 0x1b, 0x2c
+  },
+  {
+    0x02, 0x11, 0x24, 0x3b, 0x0e, 0x1d, 0x30, 0x07,
+    0x1a, 0x29, 0x3c, 0x13, 0x26, 0x35, 0x08, 0x1f,
+    0x32, 0x01, 0x14, 0x2b, 0x3e, 0x0d, 0x20, 0x37,
+    0x0a, 0x19, 0x2c, 0x03, 0x16, 0x25, 0x38, 0x0f,
+    0x22, 0x31, 0x04, 0x1b, 0x2e, 0x3d, 0x10, 0x27,
+    0x3a, 0x09, 0x1c, 0x33, 0x06, 0x15, 0x28, 0x3f,
+    0x12, 0x21, 0x34, 0x0b, 0x1e, 0x2d, 0x00, 0x17,
+    0x2a, 0x39, 0x0c, 0x23, 0x36, 0x05, 0x18, 0x2f
+  },
+  {
+    0x03, 0x10, 0x25, 0x3a, 0x0f, 0x1c, 0x31, 0x06,
+    0x1b, 0x28, 0x3d, 0x12, 0x27, 0x34, 0x09, 0x1e,
+    0x33, 0x00, 0x15, 0x2a, 0x3f, 0x0c, 0x21, 0x36,
+    0x0b, 0x18, 0x2d, 0x02, 0x17, 0x24, 0x39, 0x0e,
+    0x23, 0x30, 0x05, 0x1a, 0x2f, 0x3c, 0x11, 0x26,
+    0x3b, 0x08, 0x1d, 0x32, 0x07, 0x14, 0x29, 0x3e,
+    0x13, 0x20, 0x35, 0x0a, 0x1f, 0x2c, 0x01, 0x16,
+    0x2b, 0x38, 0x0d, 0x22, 0x37, 0x04, 0x19, 0x2e
+  },
+  {
+    0x04, 0x17, 0x22, 0x3d, 0x08, 0x1b, 0x36, 0x01,
+    0x1c, 0x2f, 0x3a, 0x15, 0x20, 0x33, 0x0e, 0x19,
+    0x34, 0x07, 0x12, 0x2d, 0x38, 0x0b, 0x26, 0x31,
+    0x0c, 0x1f, 0x2a, 0x05, 0x10, 0x23, 0x3e, 0x09,
+    0x24, 0x37, 0x02, 0x1d, 0x28, 0x3b, 0x16, 0x21,
+    0x3c, 0x0f, 0x1a, 0x35, 0x00, 0x13, 0x2e, 0x39,
+    0x14, 0x27, 0x32, 0x0d, 0x18, 0x2b, 0x06, 0x11,
+    0x2c, 0x3f, 0x0a, 0x25, 0x30, 0x03, 0x1e, 0x29
+  },
+  {
+    0x05, 0x16, 0x23, 0x3c, 0x09, 0x1a, 0x37, 0x00,
+    0x1d, 0x2e, 0x3b, 0x14, 0x21, 0x32, 0x0f, 0x18,
+    0x35, 0x06, 0x13, 0x2c, 0x39, 0x0a, 0x27, 0x30,
+    0x0d, 0x1e, 0x2b, 0x04, 0x11, 0x22, 0x3f, 0x08,
+    0x25, 0x36, 0x03, 0x1c, 0x29, 0x3a, 0x17, 0x20,
+    0x3d, 0x0e, 0x1b, 0x34, 0x01, 0x12, 0x2f, 0x38,
+    0x15, 0x26, 0x33, 0x0c, 0x19, 0x2a, 0x07, 0x10,
+    0x2d, 0x3e, 0x0b, 0x24, 0x31, 0x02, 0x1f, 0x28
+  },
+  {
+    0x06, 0x15, 0x20, 0x3f, 0x0a, 0x19, 0x34, 0x03,
+    0x1e, 0x2d, 0x38, 0x17, 0x22, 0x31, 0x0c, 0x1b,
+    0x36, 0x05, 0x10, 0x2f, 0x3a, 0x09, 0x24, 0x33,
+    0x0e, 0x1d, 0x28, 0x07, 0x12, 0x21, 0x3c, 0x0b,
+    0x26, 0x35, 0x00, 0x1f, 0x2a, 0x39, 0x14, 0x23,
+    0x3e, 0x0d, 0x18, 0x37, 0x02, 0x11, 0x2c, 0x3b,
+    0x16, 0x25, 0x30, 0x0f, 0x1a, 0x29, 0x04, 0x13,
+    0x2e, 0x3d, 0x08, 0x27, 0x32, 0x01, 0x1c, 0x2b
+  },
+  {
+    0x07, 0x14, 0x21, 0x3e, 0x0b, 0x18, 0x35, 0x02,
+    0x1f, 0x2c, 0x39, 0x16, 0x23, 0x30, 0x0d, 0x1a,
+    0x37, 0x04, 0x11, 0x2e, 0x3b, 0x08, 0x25, 0x32,
+    0x0f, 0x1c, 0x29, 0x06, 0x13, 0x20, 0x3d, 0x0a,
+    0x27, 0x34, 0x01, 0x1e, 0x2b, 0x38, 0x15, 0x22,
+    0x3f, 0x0c, 0x19, 0x36, 0x03, 0x10, 0x2d, 0x3a,
+    0x17, 0x24, 0x31, 0x0e, 0x1b, 0x28, 0x05, 0x12,
+    0x2f, 0x3c, 0x09, 0x26, 0x33, 0x00, 0x1d, 0x2a
+  },
+  {
+    0x08, 0x1b, 0x2e, 0x31, 0x04, 0x17, 0x3a, 0x0d,
+    0x10, 0x23, 0x36, 0x19, 0x2c, 0x3f, 0x02, 0x15,
+    0x38, 0x0b, 0x1e, 0x21, 0x34, 0x07, 0x2a, 0x3d,
+    0x00, 0x13, 0x26, 0x09, 0x1c, 0x2f, 0x32, 0x05,
+    0x28, 0x3b, 0x0e, 0x11, 0x24, 0x37, 0x1a, 0x2d,
+    0x30, 0x03, 0x16, 0x39, 0x0c, 0x1f, 0x22, 0x35,
+    0x18, 0x2b, 0x3e, 0x01, 0x14, 0x27, 0x0a, 0x1d,
+    0x20, 0x33, 0x06, 0x29, 0x3c, 0x0f, 0x12, 0x25
+  },
+  {
+    0x09, 0x1a, 0x2f, 0x30, 0x05, 0x16, 0x3b, 0x0c,
+    0x11, 0x22, 0x37, 0x18, 0x2d, 0x3e, 0x03, 0x14,
+    0x39, 0x0a, 0x1f, 0x20, 0x35, 0x06, 0x2b, 0x3c,
+    0x01, 0x12, 0x27, 0x08, 0x1d, 0x2e, 0x33, 0x04,
+    0x29, 0x3a, 0x0f, 0x10, 0x25, 0x36, 0x1b, 0x2c,
+    0x31, 0x02, 0x17, 0x38, 0x0d, 0x1e, 0x23, 0x34,
+    0x19, 0x2a, 0x3f, 0x00, 0x15, 0x26, 0x0b, 0x1c,
+    0x21, 0x32, 0x07, 0x28, 0x3d, 0x0e, 0x13, 0x24
+  },
+  {
+    0x0a, 0x19, 0x2c, 0x33, 0x06, 0x15, 0x38, 0x0f,
+    0x12, 0x21, 0x34, 0x1b, 0x2e, 0x3d, 0x00, 0x17,
+    0x3a, 0x09, 0x1c, 0x23, 0x36, 0x05, 0x28, 0x3f,
+    0x02, 0x11, 0x24, 0x0b, 0x1e, 0x2d, 0x30, 0x07,
+    0x2a, 0x39, 0x0c, 0x13, 0x26, 0x35, 0x18, 0x2f,
+    0x32, 0x01, 0x14, 0x3b, 0x0e, 0x1d, 0x20, 0x37,
+    0x1a, 0x29, 0x3c, 0x03, 0x16, 0x25, 0x08, 0x1f,
+    0x22, 0x31, 0x04, 0x2b, 0x3e, 0x0d, 0x10, 0x27
+  },
+  {
+    0x0b, 0x18, 0x2d, 0x32, 0x07, 0x14, 0x39, 0x0e,
+    0x13, 0x20, 0x35, 0x1a, 0x2f, 0x3c, 0x01, 0x16,
+    0x3b, 0x08, 0x1d, 0x22, 0x37, 0x04, 0x29, 0x3e,
+    0x03, 0x10, 0x25, 0x0a, 0x1f, 0x2c, 0x31, 0x06,
+    0x2b, 0x38, 0x0d, 0x12, 0x27, 0x34, 0x19, 0x2e,
+    0x33, 0x00, 0x15, 0x3a, 0x0f, 0x1c, 0x21, 0x36,
+    0x1b, 0x28, 0x3d, 0x02, 0x17, 0x24, 0x09, 0x1e,
+    0x23, 0x30, 0x05, 0x2a, 0x3f, 0x0c, 0x11, 0x26
+  },
+  {
+    0x0c, 0x1f, 0x2a, 0x35, 0x00, 0x13, 0x3e, 0x09,
+    0x14, 0x27, 0x32, 0x1d, 0x28, 0x3b, 0x06, 0x11,
+    0x3c, 0x0f, 0x1a, 0x25, 0x30, 0x03, 0x2e, 0x39,
+    0x04, 0x17, 0x22, 0x0d, 0x18, 0x2b, 0x36, 0x01,
+    0x2c, 0x3f, 0x0a, 0x15, 0x20, 0x33, 0x1e, 0x29,
+    0x34, 0x07, 0x12, 0x3d, 0x08, 0x1b, 0x26, 0x31,
+    0x1c, 0x2f, 0x3a, 0x05, 0x10, 0x23, 0x0e, 0x19,
+    0x24, 0x37, 0x02, 0x2d, 0x38, 0x0b, 0x16, 0x21
+  },
+  {
+    0x0d, 0x1e, 0x2b, 0x34, 0x01, 0x12, 0x3f, 0x08,
+    0x15, 0x26, 0x33, 0x1c, 0x29, 0x3a, 0x07, 0x10,
+    0x3d, 0x0e, 0x1b, 0x24, 0x31, 0x02, 0x2f, 0x38,
+    0x05, 0x16, 0x23, 0x0c, 0x19, 0x2a, 0x37, 0x00,
+    0x2d, 0x3e, 0x0b, 0x14, 0x21, 0x32, 0x1f, 0x28,
+    0x35, 0x06, 0x13, 0x3c, 0x09, 0x1a, 0x27, 0x30,
+    0x1d, 0x2e, 0x3b, 0x04, 0x11, 0x22, 0x0f, 0x18,
+    0x25, 0x36, 0x03, 0x2c, 0x39, 0x0a, 0x17, 0x20
+  },
+  {
+    0x0e, 0x1d, 0x28, 0x37, 0x02, 0x11, 0x3c, 0x0b,
+    0x16, 0x25, 0x30, 0x1f, 0x2a, 0x39, 0x04, 0x13,
+    0x3e, 0x0d, 0x18, 0x27, 0x32, 0x01, 0x2c, 0x3b,
+    0x06, 0x15, 0x20, 0x0f, 0x1a, 0x29, 0x34, 0x03,
+    0x2e, 0x3d, 0x08, 0x17, 0x22, 0x31, 0x1c, 0x2b,
+    0x36, 0x05, 0x10, 0x3f, 0x0a, 0x19, 0x24, 0x33,
+    0x1e, 0x2d, 0x38, 0x07, 0x12, 0x21, 0x0c, 0x1b,
+    0x26, 0x35, 0x00, 0x2f, 0x3a, 0x09, 0x14, 0x23
+  },
+  {
+    0x0f, 0x1c, 0x29, 0x36, 0x03, 0x10, 0x3d, 0x0a,
+    0x17, 0x24, 0x31, 0x1e, 0x2b, 0x38, 0x05, 0x12,
+    0x3f, 0x0c, 0x19, 0x26, 0x33, 0x00, 0x2d, 0x3a,
+    0x07, 0x14, 0x21, 0x0e, 0x1b, 0x28, 0x35, 0x02,
+    0x2f, 0x3c, 0x09, 0x16, 0x23, 0x30, 0x1d, 0x2a,
+    0x37, 0x04, 0x11, 0x3e, 0x0b, 0x18, 0x25, 0x32,
+    0x1f, 0x2c, 0x39, 0x06, 0x13, 0x20, 0x0d, 0x1a,
+    0x27, 0x34, 0x01, 0x2e, 0x3b, 0x08, 0x15, 0x22
+  },
+  {
+    0x10, 0x03, 0x36, 0x29, 0x1c, 0x0f, 0x22, 0x15,
+    0x08, 0x3b, 0x2e, 0x01, 0x34, 0x27, 0x1a, 0x0d,
+    0x20, 0x13, 0x06, 0x39, 0x2c, 0x1f, 0x32, 0x25,
+    0x18, 0x0b, 0x3e, 0x11, 0x04, 0x37, 0x2a, 0x1d,
+    0x30, 0x23, 0x16, 0x09, 0x3c, 0x2f, 0x02, 0x35,
+    0x28, 0x1b, 0x0e, 0x21, 0x14, 0x07, 0x3a, 0x2d,
+    0x00, 0x33, 0x26, 0x19, 0x0c, 0x3f, 0x12, 0x05,
+    0x38, 0x2b, 0x1e, 0x31, 0x24, 0x17, 0x0a, 0x3d
+  },
+  {
+    0x11, 0x02, 0x37, 0x28, 0x1d, 0x0e, 0x23, 0x14,
+    0x09, 0x3a, 0x2f, 0x00, 0x35, 0x26, 0x1b, 0x0c,
+    0x21, 0x12, 0x07, 0x38, 0x2d, 0x1e, 0x33, 0x24,
+    0x19, 0x0a, 0x3f, 0x10, 0x05, 0x36, 0x2b, 0x1c,
+    0x31, 0x22, 0x17, 0x08, 0x3d, 0x2e, 0x03, 0x34,
+    0x29, 0x1a, 0x0f, 0x20, 0x15, 0x06, 0x3b, 0x2c,
+    0x01, 0x32, 0x27, 0x18, 0x0d, 0x3e, 0x13, 0x04,
+    0x39, 0x2a, 0x1f, 0x30, 0x25, 0x16, 0x0b, 0x3c
+  },
+  {
+    0x12, 0x01, 0x34, 0x2b, 0x1e, 0x0d, 0x20, 0x17,
+    0x0a, 0x39, 0x2c, 0x03, 0x36, 0x25, 0x18, 0x0f,
+    0x22, 0x11, 0x04, 0x3b, 0x2e, 0x1d, 0x30, 0x27,
+    0x1a, 0x09, 0x3c, 0x13, 0x06, 0x35, 0x28, 0x1f,
+    0x32, 0x21, 0x14, 0x0b, 0x3e, 0x2d, 0x00, 0x37,
+    0x2a, 0x19, 0x0c, 0x23, 0x16, 0x05, 0x38, 0x2f,
+    0x02, 0x31, 0x24, 0x1b, 0x0e, 0x3d, 0x10, 0x07,
+    0x3a, 0x29, 0x1c, 0x33, 0x26, 0x15, 0x08, 0x3f
+  },
+  {
+    0x13, 0x00, 0x35, 0x2a, 0x1f, 0x0c, 0x21, 0x16,
+    0x0b, 0x38, 0x2d, 0x02, 0x37, 0x24, 0x19, 0x0e,
+    0x23, 0x10, 0x05, 0x3a, 0x2f, 0x1c, 0x31, 0x26,
+    0x1b, 0x08, 0x3d, 0x12, 0x07, 0x34, 0x29, 0x1e,
+    0x33, 0x20, 0x15, 0x0a, 0x3f, 0x2c, 0x01, 0x36,
+    0x2b, 0x18, 0x0d, 0x22, 0x17, 0x04, 0x39, 0x2e,
+    0x03, 0x30, 0x25, 0x1a, 0x0f, 0x3c, 0x11, 0x06,
+    0x3b, 0x28, 0x1d, 0x32, 0x27, 0x14, 0x09, 0x3e
+  },
+  {
+    0x14, 0x07, 0x32, 0x2d, 0x18, 0x0b, 0x26, 0x11,
+    0x0c, 0x3f, 0x2a, 0x05, 0x30, 0x23, 0x1e, 0x09,
+    0x24, 0x17, 0x02, 0x3d, 0x28, 0x1b, 0x36, 0x21,
+    0x1c, 0x0f, 0x3a, 0x15, 0x00, 0x33, 0x2e, 0x19,
+    0x34, 0x27, 0x12, 0x0d, 0x38, 0x2b, 0x06, 0x31,
+    0x2c, 0x1f, 0x0a, 0x25, 0x10, 0x03, 0x3e, 0x29,
+    0x04, 0x37, 0x22, 0x1d, 0x08, 0x3b, 0x16, 0x01,
+    0x3c, 0x2f, 0x1a, 0x35, 0x20, 0x13, 0x0e, 0x39
+  },
+  {
+    0x15, 0x06, 0x33, 0x2c, 0x19, 0x0a, 0x27, 0x10,
+    0x0d, 0x3e, 0x2b, 0x04, 0x31, 0x22, 0x1f, 0x08,
+    0x25, 0x16, 0x03, 0x3c, 0x29, 0x1a, 0x37, 0x20,
+    0x1d, 0x0e, 0x3b, 0x14, 0x01, 0x32, 0x2f, 0x18,
+    0x35, 0x26, 0x13, 0x0c, 0x39, 0x2a, 0x07, 0x30,
+    0x2d, 0x1e, 0x0b, 0x24, 0x11, 0x02, 0x3f, 0x28,
+    0x05, 0x36, 0x23, 0x1c, 0x09, 0x3a, 0x17, 0x00,
+    0x3d, 0x2e, 0x1b, 0x34, 0x21, 0x12, 0x0f, 0x38
+  },
+  {
+    0x16, 0x05, 0x30, 0x2f, 0x1a, 0x09, 0x24, 0x13,
+    0x0e, 0x3d, 0x28, 0x07, 0x32, 0x21, 0x1c, 0x0b,
+    0x26, 0x15, 0x00, 0x3f, 0x2a, 0x19, 0x34, 0x23,
+    0x1e, 0x0d, 0x38, 0x17, 0x02, 0x31, 0x2c, 0x1b,
+    0x36, 0x25, 0x10, 0x0f, 0x3a, 0x29, 0x04, 0x33,
+    0x2e, 0x1d, 0x08, 0x27, 0x12, 0x01, 0x3c, 0x2b,
+    0x06, 0x35, 0x20, 0x1f, 0x0a, 0x39, 0x14, 0x03,
+    0x3e, 0x2d, 0x18, 0x37, 0x22, 0x11, 0x0c, 0x3b
+  },
+  {
+    0x17, 0x04, 0x31, 0x2e, 0x1b, 0x08, 0x25, 0x12,
+    0x0f, 0x3c, 0x29, 0x06, 0x33, 0x20, 0x1d, 0x0a,
+    0x27, 0x14, 0x01, 0x3e, 0x2b, 0x18, 0x35, 0x22,
+    0x1f, 0x0c, 0x39, 0x16, 0x03, 0x30, 0x2d, 0x1a,
+    0x37, 0x24, 0x11, 0x0e, 0x3b, 0x28, 0x05, 0x32,
+    0x2f, 0x1c, 0x09, 0x26, 0x13, 0x00, 0x3d, 0x2a,
+    0x07, 0x34, 0x21, 0x1e, 0x0b, 0x38, 0x15, 0x02,
+    0x3f, 0x2c, 0x19, 0x36, 0x23, 0x10, 0x0d, 0x3a
+  },
+  {
+    0x18, 0x0b, 0x3e, 0x21, 0x14, 0x07, 0x2a, 0x1d,
+    0x00, 0x33, 0x26, 0x09, 0x3c, 0x2f, 0x12, 0x05,
+    0x28, 0x1b, 0x0e, 0x31, 0x24, 0x17, 0x3a, 0x2d,
+    0x10, 0x03, 0x36, 0x19, 0x0c, 0x3f, 0x22, 0x15,
+    0x38, 0x2b, 0x1e, 0x01, 0x34, 0x27, 0x0a, 0x3d,
+    0x20, 0x13, 0x06, 0x29, 0x1c, 0x0f, 0x32, 0x25,
+    0x08, 0x3b, 0x2e, 0x11, 0x04, 0x37, 0x1a, 0x0d,
+    0x30, 0x23, 0x16, 0x39, 0x2c, 0x1f, 0x02, 0x35
+  },
+  {
+    0x19, 0x0a, 0x3f, 0x20, 0x15, 0x06, 0x2b, 0x1c,
+    0x01, 0x32, 0x27, 0x08, 0x3d, 0x2e, 0x13, 0x04,
+    0x29, 0x1a, 0x0f, 0x30, 0x25, 0x16, 0x3b, 0x2c,
+    0x11, 0x02, 0x37, 0x18, 0x0d, 0x3e, 0x23, 0x14,
+    0x39, 0x2a, 0x1f, 0x00, 0x35, 0x26, 0x0b, 0x3c,
+    0x21, 0x12, 0x07, 0x28, 0x1d, 0x0e, 0x33, 0x24,
+    0x09, 0x3a, 0x2f, 0x10, 0x05, 0x36, 0x1b, 0x0c,
+    0x31, 0x22, 0x17, 0x38, 0x2d, 0x1e, 0x03, 0x34
+  },
+  {
+    0x1a, 0x09, 0x3c, 0x23, 0x16, 0x05, 0x28, 0x1f,
+    0x02, 0x31, 0x24, 0x0b, 0x3e, 0x2d, 0x10, 0x07,
+    0x2a, 0x19, 0x0c, 0x33, 0x26, 0x15, 0x38, 0x2f,
+    0x12, 0x01, 0x34, 0x1b, 0x0e, 0x3d, 0x20, 0x17,
+    0x3a, 0x29, 0x1c, 0x03, 0x36, 0x25, 0x08, 0x3f,
+    0x22, 0x11, 0x04, 0x2b, 0x1e, 0x0d, 0x30, 0x27,
+    0x0a, 0x39, 0x2c, 0x13, 0x06, 0x35, 0x18, 0x0f,
+    0x32, 0x21, 0x14, 0x3b, 0x2e, 0x1d, 0x00, 0x37
+  },
+  {
+    0x1b, 0x08, 0x3d, 0x22, 0x17, 0x04, 0x29, 0x1e,
+    0x03, 0x30, 0x25, 0x0a, 0x3f, 0x2c, 0x11, 0x06,
+    0x2b, 0x18, 0x0d, 0x32, 0x27, 0x14, 0x39, 0x2e,
+    0x13, 0x00, 0x35, 0x1a, 0x0f, 0x3c, 0x21, 0x16,
+    0x3b, 0x28, 0x1d, 0x02, 0x37, 0x24, 0x09, 0x3e,
+    0x23, 0x10, 0x05, 0x2a, 0x1f, 0x0c, 0x31, 0x26,
+    0x0b, 0x38, 0x2d, 0x12, 0x07, 0x34, 0x19, 0x0e,
+    0x33, 0x20, 0x15, 0x3a, 0x2f, 0x1c, 0x01, 0x36
+  },
+  {
+    0x1c, 0x0f, 0x3a, 0x25, 0x10, 0x03, 0x2e, 0x19,
+    0x04, 0x37, 0x22, 0x0d, 0x38, 0x2b, 0x16, 0x01,
+    0x2c, 0x1f, 0x0a, 0x35, 0x20, 0x13, 0x3e, 0x29,
+    0x14, 0x07, 0x32, 0x1d, 0x08, 0x3b, 0x26, 0x11,
+    0x3c, 0x2f, 0x1a, 0x05, 0x30, 0x23, 0x0e, 0x39,
+    0x24, 0x17, 0x02, 0x2d, 0x18, 0x0b, 0x36, 0x21,
+    0x0c, 0x3f, 0x2a, 0x15, 0x00, 0x33, 0x1e, 0x09,
+    0x34, 0x27, 0x12, 0x3d, 0x28, 0x1b, 0x06, 0x31
+  },
+  {
+    0x1d, 0x0e, 0x3b, 0x24, 0x11, 0x02, 0x2f, 0x18,
+    0x05, 0x36, 0x23, 0x0c, 0x39, 0x2a, 0x17, 0x00,
+    0x2d, 0x1e, 0x0b, 0x34, 0x21, 0x12, 0x3f, 0x28,
+    0x15, 0x06, 0x33, 0x1c, 0x09, 0x3a, 0x27, 0x10,
+    0x3d, 0x2e, 0x1b, 0x04, 0x31, 0x22, 0x0f, 0x38,
+    0x25, 0x16, 0x03, 0x2c, 0x19, 0x0a, 0x37, 0x20,
+    0x0d, 0x3e, 0x2b, 0x14, 0x01, 0x32, 0x1f, 0x08,
+    0x35, 0x26, 0x13, 0x3c, 0x29, 0x1a, 0x07, 0x30
+  },
+  {
+    0x1e, 0x0d, 0x38, 0x27, 0x12, 0x01, 0x2c, 0x1b,
+    0x06, 0x35, 0x20, 0x0f, 0x3a, 0x29, 0x14, 0x03,
+    0x2e, 0x1d, 0x08, 0x37, 0x22, 0x11, 0x3c, 0x2b,
+    0x16, 0x05, 0x30, 0x1f, 0x0a, 0x39, 0x24, 0x13,
+    0x3e, 0x2d, 0x18, 0x07, 0x32, 0x21, 0x0c, 0x3b,
+    0x26, 0x15, 0x00, 0x2f, 0x1a, 0x09, 0x34, 0x23,
+    0x0e, 0x3d, 0x28, 0x17, 0x02, 0x31, 0x1c, 0x0b,
+    0x36, 0x25, 0x10, 0x3f, 0x2a, 0x19, 0x04, 0x33
+  },
+  {
+    0x1f, 0x0c, 0x39, 0x26, 0x13, 0x00, 0x2d, 0x1a,
+    0x07, 0x34, 0x21, 0x0e, 0x3b, 0x28, 0x15, 0x02,
+    0x2f, 0x1c, 0x09, 0x36, 0x23, 0x10, 0x3d, 0x2a,
+    0x17, 0x04, 0x31, 0x1e, 0x0b, 0x38, 0x25, 0x12,
+    0x3f, 0x2c, 0x19, 0x06, 0x33, 0x20, 0x0d, 0x3a,
+    0x27, 0x14, 0x01, 0x2e, 0x1b, 0x08, 0x35, 0x22,
+    0x0f, 0x3c, 0x29, 0x16, 0x03, 0x30, 0x1d, 0x0a,
+    0x37, 0x24, 0x11, 0x3e, 0x2b, 0x18, 0x05, 0x32
+  },
+  {
+    0x20, 0x33, 0x06, 0x19, 0x2c, 0x3f, 0x12, 0x25,
+    0x38, 0x0b, 0x1e, 0x31, 0x04, 0x17, 0x2a, 0x3d,
+    0x10, 0x23, 0x36, 0x09, 0x1c, 0x2f, 0x02, 0x15,
+    0x28, 0x3b, 0x0e, 0x21, 0x34, 0x07, 0x1a, 0x2d,
+    0x00, 0x13, 0x26, 0x39, 0x0c, 0x1f, 0x32, 0x05,
+    0x18, 0x2b, 0x3e, 0x11, 0x24, 0x37, 0x0a, 0x1d,
+    0x30, 0x03, 0x16, 0x29, 0x3c, 0x0f, 0x22, 0x35,
+    0x08, 0x1b, 0x2e, 0x01, 0x14, 0x27, 0x3a, 0x0d
+  },
+  {
+    0x21, 0x32, 0x07, 0x18, 0x2d, 0x3e, 0x13, 0x24,
+    0x39, 0x0a, 0x1f, 0x30, 0x05, 0x16, 0x2b, 0x3c,
+    0x11, 0x22, 0x37, 0x08, 0x1d, 0x2e, 0x03, 0x14,
+    0x29, 0x3a, 0x0f, 0x20, 0x35, 0x06, 0x1b, 0x2c,
+    0x01, 0x12, 0x27, 0x38, 0x0d, 0x1e, 0x33, 0x04,
+    0x19, 0x2a, 0x3f, 0x10, 0x25, 0x36, 0x0b, 0x1c,
+    0x31, 0x02, 0x17, 0x28, 0x3d, 0x0e, 0x23, 0x34,
+    0x09, 0x1a, 0x2f, 0x00, 0x15, 0x26, 0x3b, 0x0c
+  },
+  {
+    0x22, 0x31, 0x04, 0x1b, 0x2e, 0x3d, 0x10, 0x27,
+    0x3a, 0x09, 0x1c, 0x33, 0x06, 0x15, 0x28, 0x3f,
+    0x12, 0x21, 0x34, 0x0b, 0x1e, 0x2d, 0x00, 0x17,
+    0x2a, 0x39, 0x0c, 0x23, 0x36, 0x05, 0x18, 0x2f,
+    0x02, 0x11, 0x24, 0x3b, 0x0e, 0x1d, 0x30, 0x07,
+    0x1a, 0x29, 0x3c, 0x13, 0x26, 0x35, 0x08, 0x1f,
+    0x32, 0x01, 0x14, 0x2b, 0x3e, 0x0d, 0x20, 0x37,
+    0x0a, 0x19, 0x2c, 0x03, 0x16, 0x25, 0x38, 0x0f
+  },
+  {
+    0x23, 0x30, 0x05, 0x1a, 0x2f, 0x3c, 0x11, 0x26,
+    0x3b, 0x08, 0x1d, 0x32, 0x07, 0x14, 0x29, 0x3e,
+    0x13, 0x20, 0x35, 0x0a, 0x1f, 0x2c, 0x01, 0x16,
+    0x2b, 0x38, 0x0d, 0x22, 0x37, 0x04, 0x19, 0x2e,
+    0x03, 0x10, 0x25, 0x3a, 0x0f, 0x1c, 0x31, 0x06,
+    0x1b, 0x28, 0x3d, 0x12, 0x27, 0x34, 0x09, 0x1e,
+    0x33, 0x00, 0x15, 0x2a, 0x3f, 0x0c, 0x21, 0x36,
+    0x0b, 0x18, 0x2d, 0x02, 0x17, 0x24, 0x39, 0x0e
+  },
+  {
+    0x24, 0x37, 0x02, 0x1d, 0x28, 0x3b, 0x16, 0x21,
+    0x3c, 0x0f, 0x1a, 0x35, 0x00, 0x13, 0x2e, 0x39,
+    0x14, 0x27, 0x32, 0x0d, 0x18, 0x2b, 0x06, 0x11,
+    0x2c, 0x3f, 0x0a, 0x25, 0x30, 0x03, 0x1e, 0x29,
+    0x04, 0x17, 0x22, 0x3d, 0x08, 0x1b, 0x36, 0x01,
+    0x1c, 0x2f, 0x3a, 0x15, 0x20, 0x33, 0x0e, 0x19,
+    0x34, 0x07, 0x12, 0x2d, 0x38, 0x0b, 0x26, 0x31,
+    0x0c, 0x1f, 0x2a, 0x05, 0x10, 0x23, 0x3e, 0x09
+  },
+  {
+    0x25, 0x36, 0x03, 0x1c, 0x29, 0x3a, 0x17, 0x20,
+    0x3d, 0x0e, 0x1b, 0x34, 0x01, 0x12, 0x2f, 0x38,
+    0x15, 0x26, 0x33, 0x0c, 0x19, 0x2a, 0x07, 0x10,
+    0x2d, 0x3e, 0x0b, 0x24, 0x31, 0x02, 0x1f, 0x28,
+    0x05, 0x16, 0x23, 0x3c, 0x09, 0x1a, 0x37, 0x00,
+    0x1d, 0x2e, 0x3b, 0x14, 0x21, 0x32, 0x0f, 0x18,
+    0x35, 0x06, 0x13, 0x2c, 0x39, 0x0a, 0x27, 0x30,
+    0x0d, 0x1e, 0x2b, 0x04, 0x11, 0x22, 0x3f, 0x08
+  },
+  {
+    0x26, 0x35, 0x00, 0x1f, 0x2a, 0x39, 0x14, 0x23,
+    0x3e, 0x0d, 0x18, 0x37, 0x02, 0x11, 0x2c, 0x3b,
+    0x16, 0x25, 0x30, 0x0f, 0x1a, 0x29, 0x04, 0x13,
+    0x2e, 0x3d, 0x08, 0x27, 0x32, 0x01, 0x1c, 0x2b,
+    0x06, 0x15, 0x20, 0x3f, 0x0a, 0x19, 0x34, 0x03,
+    0x1e, 0x2d, 0x38, 0x17, 0x22, 0x31, 0x0c, 0x1b,
+    0x36, 0x05, 0x10, 0x2f, 0x3a, 0x09, 0x24, 0x33,
+    0x0e, 0x1d, 0x28, 0x07, 0x12, 0x21, 0x3c, 0x0b
+  },
+  {
+    0x27, 0x34, 0x01, 0x1e, 0x2b, 0x38, 0x15, 0x22,
+    0x3f, 0x0c, 0x19, 0x36, 0x03, 0x10, 0x2d, 0x3a,
+    0x17, 0x24, 0x31, 0x0e, 0x1b, 0x28, 0x05, 0x12,
+    0x2f, 0x3c, 0x09, 0x26, 0x33, 0x00, 0x1d, 0x2a,
+    0x07, 0x14, 0x21, 0x3e, 0x0b, 0x18, 0x35, 0x02,
+    0x1f, 0x2c, 0x39, 0x16, 0x23, 0x30, 0x0d, 0x1a,
+    0x37, 0x04, 0x11, 0x2e, 0x3b, 0x08, 0x25, 0x32,
+    0x0f, 0x1c, 0x29, 0x06, 0x13, 0x20, 0x3d, 0x0a
+  },
+  {
+    0x28, 0x3b, 0x0e, 0x11, 0x24, 0x37, 0x1a, 0x2d,
+    0x30, 0x03, 0x16, 0x39, 0x0c, 0x1f, 0x22, 0x35,
+    0x18, 0x2b, 0x3e, 0x01, 0x14, 0x27, 0x0a, 0x1d,
+    0x20, 0x33, 0x06, 0x29, 0x3c, 0x0f, 0x12, 0x25,
+    0x08, 0x1b, 0x2e, 0x31, 0x04, 0x17, 0x3a, 0x0d,
+    0x10, 0x23, 0x36, 0x19, 0x2c, 0x3f, 0x02, 0x15,
+    0x38, 0x0b, 0x1e, 0x21, 0x34, 0x07, 0x2a, 0x3d,
+    0x00, 0x13, 0x26, 0x09, 0x1c, 0x2f, 0x32, 0x05
+  },
+  {
+    0x29, 0x3a, 0x0f, 0x10, 0x25, 0x36, 0x1b, 0x2c,
+    0x31, 0x02, 0x17, 0x38, 0x0d, 0x1e, 0x23, 0x34,
+    0x19, 0x2a, 0x3f, 0x00, 0x15, 0x26, 0x0b, 0x1c,
+    0x21, 0x32, 0x07, 0x28, 0x3d, 0x0e, 0x13, 0x24,
+    0x09, 0x1a, 0x2f, 0x30, 0x05, 0x16, 0x3b, 0x0c,
+    0x11, 0x22, 0x37, 0x18, 0x2d, 0x3e, 0x03, 0x14,
+    0x39, 0x0a, 0x1f, 0x20, 0x35, 0x06, 0x2b, 0x3c,
+    0x01, 0x12, 0x27, 0x08, 0x1d, 0x2e, 0x33, 0x04
+  },
+  {
+    0x2a, 0x39, 0x0c, 0x13, 0x26, 0x35, 0x18, 0x2f,
+    0x32, 0x01, 0x14, 0x3b, 0x0e, 0x1d, 0x20, 0x37,
+    0x1a, 0x29, 0x3c, 0x03, 0x16, 0x25, 0x08, 0x1f,
+    0x22, 0x31, 0x04, 0x2b, 0x3e, 0x0d, 0x10, 0x27,
+    0x0a, 0x19, 0x2c, 0x33, 0x06, 0x15, 0x38, 0x0f,
+    0x12, 0x21, 0x34, 0x1b, 0x2e, 0x3d, 0x00, 0x17,
+    0x3a, 0x09, 0x1c, 0x23, 0x36, 0x05, 0x28, 0x3f,
+    0x02, 0x11, 0x24, 0x0b, 0x1e, 0x2d, 0x30, 0x07
+  },
+  {
+    0x2b, 0x38, 0x0d, 0x12, 0x27, 0x34, 0x19, 0x2e,
+    0x33, 0x00, 0x15, 0x3a, 0x0f, 0x1c, 0x21, 0x36,
+    0x1b, 0x28, 0x3d, 0x02, 0x17, 0x24, 0x09, 0x1e,
+    0x23, 0x30, 0x05, 0x2a, 0x3f, 0x0c, 0x11, 0x26,
+    0x0b, 0x18, 0x2d, 0x32, 0x07, 0x14, 0x39, 0x0e,
+    0x13, 0x20, 0x35, 0x1a, 0x2f, 0x3c, 0x01, 0x16,
+    0x3b, 0x08, 0x1d, 0x22, 0x37, 0x04, 0x29, 0x3e,
+    0x03, 0x10, 0x25, 0x0a, 0x1f, 0x2c, 0x31, 0x06
+  },
+  {
+    0x2c, 0x3f, 0x0a, 0x15, 0x20, 0x33, 0x1e, 0x29,
+    0x34, 0x07, 0x12, 0x3d, 0x08, 0x1b, 0x26, 0x31,
+    0x1c, 0x2f, 0x3a, 0x05, 0x10, 0x23, 0x0e, 0x19,
+    0x24, 0x37, 0x02, 0x2d, 0x38, 0x0b, 0x16, 0x21,
+    0x0c, 0x1f, 0x2a, 0x35, 0x00, 0x13, 0x3e, 0x09,
+    0x14, 0x27, 0x32, 0x1d, 0x28, 0x3b, 0x06, 0x11,
+    0x3c, 0x0f, 0x1a, 0x25, 0x30, 0x03, 0x2e, 0x39,
+    0x04, 0x17, 0x22, 0x0d, 0x18, 0x2b, 0x36, 0x01
+  },
+  {
+    0x2d, 0x3e, 0x0b, 0x14, 0x21, 0x32, 0x1f, 0x28,
+    0x35, 0x06, 0x13, 0x3c, 0x09, 0x1a, 0x27, 0x30,
+    0x1d, 0x2e, 0x3b, 0x04, 0x11, 0x22, 0x0f, 0x18,
+    0x25, 0x36, 0x03, 0x2c, 0x39, 0x0a, 0x17, 0x20,
+    0x0d, 0x1e, 0x2b, 0x34, 0x01, 0x12, 0x3f, 0x08,
+    0x15, 0x26, 0x33, 0x1c, 0x29, 0x3a, 0x07, 0x10,
+    0x3d, 0x0e, 0x1b, 0x24, 0x31, 0x02, 0x2f, 0x38,
+    0x05, 0x16, 0x23, 0x0c, 0x19, 0x2a, 0x37, 0x00
+  },
+  {
+    0x2e, 0x3d, 0x08, 0x17, 0x22, 0x31, 0x1c, 0x2b,
+    0x36, 0x05, 0x10, 0x3f, 0x0a, 0x19, 0x24, 0x33,
+    0x1e, 0x2d, 0x38, 0x07, 0x12, 0x21, 0x0c, 0x1b,
+    0x26, 0x35, 0x00, 0x2f, 0x3a, 0x09, 0x14, 0x23,
+    0x0e, 0x1d, 0x28, 0x37, 0x02, 0x11, 0x3c, 0x0b,
+    0x16, 0x25, 0x30, 0x1f, 0x2a, 0x39, 0x04, 0x13,
+    0x3e, 0x0d, 0x18, 0x27, 0x32, 0x01, 0x2c, 0x3b,
+    0x06, 0x15, 0x20, 0x0f, 0x1a, 0x29, 0x34, 0x03
+  },
+  {
+    0x2f, 0x3c, 0x09, 0x16, 0x23, 0x30, 0x1d, 0x2a,
+    0x37, 0x04, 0x11, 0x3e, 0x0b, 0x18, 0x25, 0x32,
+    0x1f, 0x2c, 0x39, 0x06, 0x13, 0x20, 0x0d, 0x1a,
+    0x27, 0x34, 0x01, 0x2e, 0x3b, 0x08, 0x15, 0x22,
+    0x0f, 0x1c, 0x29, 0x36, 0x03, 0x10, 0x3d, 0x0a,
+    0x17, 0x24, 0x31, 0x1e, 0x2b, 0x38, 0x05, 0x12,
+    0x3f, 0x0c, 0x19, 0x26, 0x33, 0x00, 0x2d, 0x3a,
+    0x07, 0x14, 0x21, 0x0e, 0x1b, 0x28, 0x35, 0x02
+  },
+  {
+    0x30, 0x23, 0x16, 0x09, 0x3c, 0x2f, 0x02, 0x35,
+    0x28, 0x1b, 0x0e, 0x21, 0x14, 0x07, 0x3a, 0x2d,
+    0x00, 0x33, 0x26, 0x19, 0x0c, 0x3f, 0x12, 0x05,
+    0x38, 0x2b, 0x1e, 0x31, 0x24, 0x17, 0x0a, 0x3d,
+    0x10, 0x03, 0x36, 0x29, 0x1c, 0x0f, 0x22, 0x15,
+    0x08, 0x3b, 0x2e, 0x01, 0x34, 0x27, 0x1a, 0x0d,
+    0x20, 0x13, 0x06, 0x39, 0x2c, 0x1f, 0x32, 0x25,
+    0x18, 0x0b, 0x3e, 0x11, 0x04, 0x37, 0x2a, 0x1d
+  },
+  {
+    0x31, 0x22, 0x17, 0x08, 0x3d, 0x2e, 0x03, 0x34,
+    0x29, 0x1a, 0x0f, 0x20, 0x15, 0x06, 0x3b, 0x2c,
+    0x01, 0x32, 0x27, 0x18, 0x0d, 0x3e, 0x13, 0x04,
+    0x39, 0x2a, 0x1f, 0x30, 0x25, 0x16, 0x0b, 0x3c,
+    0x11, 0x02, 0x37, 0x28, 0x1d, 0x0e, 0x23, 0x14,
+    0x09, 0x3a, 0x2f, 0x00, 0x35, 0x26, 0x1b, 0x0c,
+    0x21, 0x12, 0x07, 0x38, 0x2d, 0x1e, 0x33, 0x24,
+    0x19, 0x0a, 0x3f, 0x10, 0x05, 0x36, 0x2b, 0x1c
+  },
+  {
+    0x32, 0x21, 0x14, 0x0b, 0x3e, 0x2d, 0x00, 0x37,
+    0x2a, 0x19, 0x0c, 0x23, 0x16, 0x05, 0x38, 0x2f,
+    0x02, 0x31, 0x24, 0x1b, 0x0e, 0x3d, 0x10, 0x07,
+    0x3a, 0x29, 0x1c, 0x33, 0x26, 0x15, 0x08, 0x3f,
+    0x12, 0x01, 0x34, 0x2b, 0x1e, 0x0d, 0x20, 0x17,
+    0x0a, 0x39, 0x2c, 0x03, 0x36, 0x25, 0x18, 0x0f,
+    0x22, 0x11, 0x04, 0x3b, 0x2e, 0x1d, 0x30, 0x27,
+    0x1a, 0x09, 0x3c, 0x13, 0x06, 0x35, 0x28, 0x1f
+  },
+  {
+    0x33, 0x20, 0x15, 0x0a, 0x3f, 0x2c, 0x01, 0x36,
+    0x2b, 0x18, 0x0d, 0x22, 0x17, 0x04, 0x39, 0x2e,
+    0x03, 0x30, 0x25, 0x1a, 0x0f, 0x3c, 0x11, 0x06,
+    0x3b, 0x28, 0x1d, 0x32, 0x27, 0x14, 0x09, 0x3e,
+    0x13, 0x00, 0x35, 0x2a, 0x1f, 0x0c, 0x21, 0x16,
+    0x0b, 0x38, 0x2d, 0x02, 0x37, 0x24, 0x19, 0x0e,
+    0x23, 0x10, 0x05, 0x3a, 0x2f, 0x1c, 0x31, 0x26,
+    0x1b, 0x08, 0x3d, 0x12, 0x07, 0x34, 0x29, 0x1e
+  },
+  {
+    0x34, 0x27, 0x12, 0x0d, 0x38, 0x2b, 0x06, 0x31,
+    0x2c, 0x1f, 0x0a, 0x25, 0x10, 0x03, 0x3e, 0x29,
+    0x04, 0x37, 0x22, 0x1d, 0x08, 0x3b, 0x16, 0x01,
+    0x3c, 0x2f, 0x1a, 0x35, 0x20, 0x13, 0x0e, 0x39,
+    0x14, 0x07, 0x32, 0x2d, 0x18, 0x0b, 0x26, 0x11,
+    0x0c, 0x3f, 0x2a, 0x05, 0x30, 0x23, 0x1e, 0x09,
+    0x24, 0x17, 0x02, 0x3d, 0x28, 0x1b, 0x36, 0x21,
+    0x1c, 0x0f, 0x3a, 0x15, 0x00, 0x33, 0x2e, 0x19
+  },
+  {
+    0x35, 0x26, 0x13, 0x0c, 0x39, 0x2a, 0x07, 0x30,
+    0x2d, 0x1e, 0x0b, 0x24, 0x11, 0x02, 0x3f, 0x28,
+    0x05, 0x36, 0x23, 0x1c, 0x09, 0x3a, 0x17, 0x00,
+    0x3d, 0x2e, 0x1b, 0x34, 0x21, 0x12, 0x0f, 0x38,
+    0x15, 0x06, 0x33, 0x2c, 0x19, 0x0a, 0x27, 0x10,
+    0x0d, 0x3e, 0x2b, 0x04, 0x31, 0x22, 0x1f, 0x08,
+    0x25, 0x16, 0x03, 0x3c, 0x29, 0x1a, 0x37, 0x20,
+    0x1d, 0x0e, 0x3b, 0x14, 0x01, 0x32, 0x2f, 0x18
+  },
+  {
+    0x36, 0x25, 0x10, 0x0f, 0x3a, 0x29, 0x04, 0x33,
+    0x2e, 0x1d, 0x08, 0x27, 0x12, 0x01, 0x3c, 0x2b,
+    0x06, 0x35, 0x20, 0x1f, 0x0a, 0x39, 0x14, 0x03,
+    0x3e, 0x2d, 0x18, 0x37, 0x22, 0x11, 0x0c, 0x3b,
+    0x16, 0x05, 0x30, 0x2f, 0x1a, 0x09, 0x24, 0x13,
+    0x0e, 0x3d, 0x28, 0x07, 0x32, 0x21, 0x1c, 0x0b,
+    0x26, 0x15, 0x00, 0x3f, 0x2a, 0x19, 0x34, 0x23,
+    0x1e, 0x0d, 0x38, 0x17, 0x02, 0x31, 0x2c, 0x1b
+  },
+  {
+    0x37, 0x24, 0x11, 0x0e, 0x3b, 0x28, 0x05, 0x32,
+    0x2f, 0x1c, 0x09, 0x26, 0x13, 0x00, 0x3d, 0x2a,
+    0x07, 0x34, 0x21, 0x1e, 0x0b, 0x38, 0x15, 0x02,
+    0x3f, 0x2c, 0x19, 0x36, 0x23, 0x10, 0x0d, 0x3a,
+    0x17, 0x04, 0x31, 0x2e, 0x1b, 0x08, 0x25, 0x12,
+    0x0f, 0x3c, 0x29, 0x06, 0x33, 0x20, 0x1d, 0x0a,
+    0x27, 0x14, 0x01, 0x3e, 0x2b, 0x18, 0x35, 0x22,
+    0x1f, 0x0c, 0x39, 0x16, 0x03, 0x30, 0x2d, 0x1a
+  },
+  {
+    0x38, 0x2b, 0x1e, 0x01, 0x34, 0x27, 0x0a, 0x3d,
+    0x20, 0x13, 0x06, 0x29, 0x1c, 0x0f, 0x32, 0x25,
+    0x08, 0x3b, 0x2e, 0x11, 0x04, 0x37, 0x1a, 0x0d,
+    0x30, 0x23, 0x16, 0x39, 0x2c, 0x1f, 0x02, 0x35,
+    0x18, 0x0b, 0x3e, 0x21, 0x14, 0x07, 0x2a, 0x1d,
+    0x00, 0x33, 0x26, 0x09, 0x3c, 0x2f, 0x12, 0x05,
+    0x28, 0x1b, 0x0e, 0x31, 0x24, 0x17, 0x3a, 0x2d,
+    0x10, 0x03, 0x36, 0x19, 0x0c, 0x3f, 0x22, 0x15
+  },
+  {
+    0x39, 0x2a, 0x1f, 0x00, 0x35, 0x26, 0x0b, 0x3c,
+    0x21, 0x12, 0x07, 0x28, 0x1d, 0x0e, 0x33, 0x24,
+    0x09, 0x3a, 0x2f, 0x10, 0x05, 0x36, 0x1b, 0x0c,
+    0x31, 0x22, 0x17, 0x38, 0x2d, 0x1e, 0x03, 0x34,
+    0x19, 0x0a, 0x3f, 0x20, 0x15, 0x06, 0x2b, 0x1c,
+    0x01, 0x32, 0x27, 0x08, 0x3d, 0x2e, 0x13, 0x04,
+    0x29, 0x1a, 0x0f, 0x30, 0x25, 0x16, 0x3b, 0x2c,
+    0x11, 0x02, 0x37, 0x18, 0x0d, 0x3e, 0x23, 0x14
+  },
+  {
+    0x3a, 0x29, 0x1c, 0x03, 0x36, 0x25, 0x08, 0x3f,
+    0x22, 0x11, 0x04, 0x2b, 0x1e, 0x0d, 0x30, 0x27,
+    0x0a, 0x39, 0x2c, 0x13, 0x06, 0x35, 0x18, 0x0f,
+    0x32, 0x21, 0x14, 0x3b, 0x2e, 0x1d, 0x00, 0x37,
+    0x1a, 0x09, 0x3c, 0x23, 0x16, 0x05, 0x28, 0x1f,
+    0x02, 0x31, 0x24, 0x0b, 0x3e, 0x2d, 0x10, 0x07,
+    0x2a, 0x19, 0x0c, 0x33, 0x26, 0x15, 0x38, 0x2f,
+    0x12, 0x01, 0x34, 0x1b, 0x0e, 0x3d, 0x20, 0x17
+  },
+  {
+    0x3b, 0x28, 0x1d, 0x02, 0x37, 0x24, 0x09, 0x3e,
+    0x23, 0x10, 0x05, 0x2a, 0x1f, 0x0c, 0x31, 0x26,
+    0x0b, 0x38, 0x2d, 0x12, 0x07, 0x34, 0x19, 0x0e,
+    0x33, 0x20, 0x15, 0x3a, 0x2f, 0x1c, 0x01, 0x36,
+    0x1b, 0x08, 0x3d, 0x22, 0x17, 0x04, 0x29, 0x1e,
+    0x03, 0x30, 0x25, 0x0a, 0x3f, 0x2c, 0x11, 0x06,
+    0x2b, 0x18, 0x0d, 0x32, 0x27, 0x14, 0x39, 0x2e,
+    0x13, 0x00, 0x35, 0x1a, 0x0f, 0x3c, 0x21, 0x16
+  },
+  {
+    0x3c, 0x2f, 0x1a, 0x05, 0x30, 0x23, 0x0e, 0x39,
+    0x24, 0x17, 0x02, 0x2d, 0x18, 0x0b, 0x36, 0x21,
+    0x0c, 0x3f, 0x2a, 0x15, 0x00, 0x33, 0x1e, 0x09,
+    0x34, 0x27, 0x12, 0x3d, 0x28, 0x1b, 0x06, 0x31,
+    0x1c, 0x0f, 0x3a, 0x25, 0x10, 0x03, 0x2e, 0x19,
+    0x04, 0x37, 0x22, 0x0d, 0x38, 0x2b, 0x16, 0x01,
+    0x2c, 0x1f, 0x0a, 0x35, 0x20, 0x13, 0x3e, 0x29,
+    0x14, 0x07, 0x32, 0x1d, 0x08, 0x3b, 0x26, 0x11
+  },
+  {
+    0x3d, 0x2e, 0x1b, 0x04, 0x31, 0x22, 0x0f, 0x38,
+    0x25, 0x16, 0x03, 0x2c, 0x19, 0x0a, 0x37, 0x20,
+    0x0d, 0x3e, 0x2b, 0x14, 0x01, 0x32, 0x1f, 0x08,
+    0x35, 0x26, 0x13, 0x3c, 0x29, 0x1a, 0x07, 0x30,
+    0x1d, 0x0e, 0x3b, 0x24, 0x11, 0x02, 0x2f, 0x18,
+    0x05, 0x36, 0x23, 0x0c, 0x39, 0x2a, 0x17, 0x00,
+    0x2d, 0x1e, 0x0b, 0x34, 0x21, 0x12, 0x3f, 0x28,
+    0x15, 0x06, 0x33, 0x1c, 0x09, 0x3a, 0x27, 0x10
+  },
+  {
+    0x3e, 0x2d, 0x18, 0x07, 0x32, 0x21, 0x0c, 0x3b,
+    0x26, 0x15, 0x00, 0x2f, 0x1a, 0x09, 0x34, 0x23,
+    0x0e, 0x3d, 0x28, 0x17, 0x02, 0x31, 0x1c, 0x0b,
+    0x36, 0x25, 0x10, 0x3f, 0x2a, 0x19, 0x04, 0x33,
+    0x1e, 0x0d, 0x38, 0x27, 0x12, 0x01, 0x2c, 0x1b,
+    0x06, 0x35, 0x20, 0x0f, 0x3a, 0x29, 0x14, 0x03,
+    0x2e, 0x1d, 0x08, 0x37, 0x22, 0x11, 0x3c, 0x2b,
+    0x16, 0x05, 0x30, 0x1f, 0x0a, 0x39, 0x24, 0x13
+  },
+  {
+    0x3f, 0x2c, 0x19, 0x06, 0x33, 0x20, 0x0d, 0x3a,
+    0x27, 0x14, 0x01, 0x2e, 0x1b, 0x08, 0x35, 0x22,
+    0x0f, 0x3c, 0x29, 0x16, 0x03, 0x30, 0x1d, 0x0a,
+    0x37, 0x24, 0x11, 0x3e, 0x2b, 0x18, 0x05, 0x32,
+    0x1f, 0x0c, 0x39, 0x26, 0x13, 0x00, 0x2d, 0x1a,
+    0x07, 0x34, 0x21, 0x0e, 0x3b, 0x28, 0x15, 0x02,
+    0x2f, 0x1c, 0x09, 0x36, 0x23, 0x10, 0x3d, 0x2a,
+    0x17, 0x04, 0x31, 0x1e, 0x0b, 0x38, 0x25, 0x12
+  }
+};
+
+#endif